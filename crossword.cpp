@@ -3,16 +3,22 @@
 
 #include "cwc/dict.hh"
 #include "cwc/letterdict.hh"
+#include "cwc/bitdict.hh"
+#include "cwc/mappeddict.hh"
 #include "cwc/cwc.hh"
+#include "cwc/portfolio.hh"
+#include "cwc/wordcompiler.hh"
 
 #include <random>
 #include <algorithm>
 #include <sstream>
+#include <chrono>
 
 #include <QDebug>
 #include <QFile>
 #include <QElapsedTimer>
 #include <QDir>
+#include <QCoreApplication>
 
 Crossword::Crossword(QObject *parent) : QObject(parent),
     m_grid(nullptr)
@@ -53,7 +59,7 @@ QString Crossword::correctAt(const int index)
     if (m_grid->cellno(index).isoutside()) {
         return "x";
     }
-    return QString::fromStdString(m_grid->cellno(index).tostring()).toUpper();
+    return QString::fromStdString(m_grid->cellno(index).tostring(m_grid->alphabet())).toUpper();
 
 }
 
@@ -150,21 +156,63 @@ void Crossword::parseWordlist(const QString &filePath)
     }
 }
 
+namespace {
+
+// logs how a fill is going, once a second
+class FillProgress : public Progress {
+public:
+    FillProgress() : Progress(1000) {}
+    void progress(long nodes, long backtracks, int depth) override {
+        qDebug() << "Tried" << nodes << "letters," << backtracks << "dead ends," << depth << "deep";
+    }
+};
+
+const char *outcomeName(Compiler::Outcome outcome)
+{
+    switch (outcome) {
+    case Compiler::solved: return "filled";
+    case Compiler::timeout: return "timed out";
+    case Compiler::cancelled: return "cancelled";
+    case Compiler::unsat: return "no fill";
+    case Compiler::incomplete: return "none found";
+    }
+    return "";
+}
+
+}
+
 void Crossword::generateCrossword()
 {
     QElapsedTimer timer;
     timer.start();
 
-    LetterDict dict;
-
-    dict.wl = new WordList;
-    for (const QString &word : m_hints.keys()) {
-        dict.wl->addWord(word.toStdString());
+    // Everything random about the puzzle follows from the seed, so a slow
+    // or odd fill can be replayed by setting RECROSSABLE_SEED to it.
+    bool seedOk = false;
+    quint64 seed = qgetenv("RECROSSABLE_SEED").toULongLong(&seedOk);
+    if (!seedOk) {
+        seed = (quint64(std::random_device()()) << 32) | std::random_device()();
     }
-    int nwords = dict.wl->numwords();
-    qDebug() << "Added" << nwords << "words";
-    for (int i=0; i<nwords; i++) {
-        dict.addword((*dict.wl)[i], i);
+    qDebug() << "Seed" << seed;
+    Random rng(seed);
+
+    // A dictionary precompiled with cwc/dictcompile from the same hint
+    // file can be mapped directly, instead of indexing every word here.
+    QString compiledPath = QString::fromLocal8Bit(qgetenv("RECROSSABLE_DICT"));
+    if (compiledPath.isEmpty()) {
+        compiledPath = QCoreApplication::applicationDirPath() + "/nyt.cwd";
+    }
+    MappedDict mappedDict;
+    BitDict builtDict;
+    Dict *dict = &builtDict;
+    if (QFile::exists(compiledPath)) {
+        try {
+            mappedDict.load(compiledPath.toStdString());
+            dict = &mappedDict;
+            qDebug() << "Mapped" << mappedDict.numwords() << "words from" << compiledPath;
+        } catch (error &e) {
+            qWarning() << "Failed to load" << compiledPath << QString::fromStdString(e.what());
+        }
     }
 
     if (m_grid) {
@@ -174,7 +222,7 @@ void Crossword::generateCrossword()
     m_grid = new Grid;
     QStringList patterns = QDir(":/patterns/").entryList(QDir::Files);
     if (!patterns.isEmpty()) {
-        QString patternName = patterns[qrand() % patterns.size()];
+        QString patternName = patterns[rng.below(patterns.size())];
         patternName = "ginsberg";
         qDebug() << "Loading pattern" << patternName;
         QFile patternFile(":/patterns/" + patternName);
@@ -191,13 +239,72 @@ void Crossword::generateCrossword()
         }
     }
 
-    qDebug() << m_grid->numopen() << "open cells";
-    FloodWalker walker(*m_grid);
-    SmartBacktracker backtracker(*m_grid);
+    if (dict == &builtDict) {
+        // only index the words that fit some word block of this grid;
+        // the slices are built on first use, so unused lengths cost nothing
+        SlotFilter filter(*m_grid);
+        builtDict.wl = new WordList;
+        for (const QString &word : m_hints.keys()) {
+            builtDict.wl->addWord(word.toStdString());
+        }
+        int nwords = builtDict.wl->numwords();
+        int nindexed = 0;
+        for (int i=0; i<nwords; i++) {
+            if (filter.fits((*builtDict.wl)[i])) {
+                builtDict.addword((*builtDict.wl)[i], i);
+                nindexed++;
+            }
+        }
+        qDebug() << "Added" << nwords << "words," << nindexed << "fit the grid";
+    }
 
-    Compiler compiler(*m_grid, walker, backtracker, dict);
-    if (!compiler.compile()) {
-        qWarning() << "Failed to compile";
+    qDebug() << m_grid->numopen() << "open cells";
+    // the compilers share the dictionary, so it has to be read-only:
+    // the BitDict once all its slices are built, or the mapped one
+    if (dict == &builtDict) {
+        builtDict.build();
+    }
+    // Give up after RECROSSABLE_TIMEOUT seconds, 10 by default and 0 for
+    // never, rather than hang on a grid the words cannot fill
+    bool timeoutOk = false;
+    int timeout = qgetenv("RECROSSABLE_TIMEOUT").toInt(&timeoutOk);
+    if (!timeoutOk || timeout < 0) {
+        timeout = 10;
+    }
+    Compiler::Clock::time_point deadline = Compiler::Clock::time_point::max();
+    if (timeout > 0) {
+        deadline = Compiler::Clock::now() + std::chrono::seconds(timeout);
+    }
+    FillProgress progress;
+    Compiler::Result result;
+
+    // RECROSSABLE_ENGINE=words fills a word at a time, on this thread;
+    // otherwise a portfolio of letter-at-a-time compilers races
+    if (qgetenv("RECROSSABLE_ENGINE") == "words") {
+        if (dict == &builtDict) {
+            m_grid->attachdomains(builtDict);
+        }
+        WordCompiler compiler(*m_grid, *dict);
+        compiler.setseed(rng.next());
+        result = compiler.compile(deadline, 0, &progress);
+        qDebug() << "Word compiler tried" << result.nodes << "words";
+        m_grid->detachdomains();
+    } else {
+        Portfolio portfolio(*m_grid, *dict);
+        if (dict == &builtDict) {
+            // let every slot keep its candidate words, narrowed as it fills
+            portfolio.usedomains(builtDict);
+        }
+        portfolio.setseed(rng.next());
+        result = portfolio.compile(deadline, 0, &progress);
+        if (result.outcome == Compiler::solved) {
+            int winner = portfolio.getwinner();
+            qDebug() << "Compiler" << winner << "of" << portfolio.numthreads()
+                     << "(" << QString::fromStdString(portfolio.strategy(winner)) << ", seed" << portfolio.getseed(winner) << ") won";
+        }
+    }
+    if (result.outcome != Compiler::solved) {
+        qWarning() << "Failed to compile:" << outcomeName(result.outcome);
     }
     m_answers = new Answers;
     *m_answers = m_grid->getanswers();
@@ -205,7 +312,7 @@ void Crossword::generateCrossword()
     m_answers->dump(std::cout);
 
 
-    delete dict.wl;
+    delete builtDict.wl;
 
     if (m_columns != m_grid->w) {
         m_columns = m_grid->w;
@@ -0,0 +1,294 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+
+#include <iostream>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "bitdict.hh"
+
+//////////////////////////////////////////////////////////////////////
+// bitset kernels
+
+// dst = a & b
+static void andbits(uint64_t *dst, const uint64_t *a, const uint64_t *b, int n) {
+    int i = 0;
+#if defined(__AVX2__)
+    for (; i + 4 <= n; i += 4) {
+        __m256i va = _mm256_loadu_si256((const __m256i *)(a + i));
+        __m256i vb = _mm256_loadu_si256((const __m256i *)(b + i));
+        _mm256_storeu_si256((__m256i *)(dst + i), _mm256_and_si256(va, vb));
+    }
+#elif defined(__SSE2__)
+    for (; i + 2 <= n; i += 2) {
+        __m128i va = _mm_loadu_si128((const __m128i *)(a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i *)(b + i));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_and_si128(va, vb));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 2 <= n; i += 2)
+        vst1q_u64(dst + i, vandq_u64(vld1q_u64(a + i), vld1q_u64(b + i)));
+#endif
+    for (; i < n; i++)
+        dst[i] = a[i] & b[i];
+}
+
+// true if a & b has any bit set
+static bool anybits(const uint64_t *a, const uint64_t *b, int n) {
+    int i = 0;
+#if defined(__AVX2__)
+    for (; i + 4 <= n; i += 4) {
+        __m256i va = _mm256_loadu_si256((const __m256i *)(a + i));
+        __m256i vb = _mm256_loadu_si256((const __m256i *)(b + i));
+        if (!_mm256_testz_si256(va, vb))
+            return true;
+    }
+#elif defined(__SSE2__)
+    for (; i + 2 <= n; i += 2) {
+        __m128i va = _mm_loadu_si128((const __m128i *)(a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i *)(b + i));
+        __m128i z = _mm_cmpeq_epi8(_mm_and_si128(va, vb), _mm_setzero_si128());
+        if (_mm_movemask_epi8(z) != 0xffff)
+            return true;
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 2 <= n; i += 2) {
+        uint64x2_t v = vandq_u64(vld1q_u64(a + i), vld1q_u64(b + i));
+        if (vgetq_lane_u64(v, 0) | vgetq_lane_u64(v, 1))
+            return true;
+    }
+#endif
+    for (; i < n; i++)
+        if (a[i] & b[i])
+            return true;
+    return false;
+}
+
+//////////////////////////////////////////////////////////////////////
+// bitdict
+
+BitDict::BitDict() {
+}
+
+void BitDict::addword(Symbol *st, int wordi) {
+    int wlen = wordlen(st);
+    if (wlen >= MAXWORDLEN)
+        return;
+    slices[wlen].words.push_back(wordi);
+    slices[wlen].built = false;
+}
+
+void BitDict::build() {
+    for (int len = 0; len < MAXWORDLEN; len++)
+        if (!slices[len].built)
+            buildslice(len);
+}
+
+void BitDict::buildslice(int len) {
+    Slice &sl = slices[len];
+    int nwords = sl.words.size();
+    sl.nblocks = (nwords + 63) / 64;
+
+    // find the letters used at each position, and give each of them
+    // a bitset
+    for (int pos = 0; pos < len; pos++) sl.all[pos] = 0;
+    for (int w = 0; w < nwords; w++) {
+        Symbol *st = (*wl)[sl.words[w]];
+        for (int pos = 0; pos < len; pos++)
+            sl.all[pos] |= st[pos].getsymbolset();
+    }
+    sl.index.assign(len * 32, -1);
+    int nsets = 0;
+    for (int pos = 0; pos < len; pos++)
+        for (int ch = 0; ch < 32; ch++)
+            if (sl.all[pos] & (SymbolSet(1) << ch))
+                sl.index[pos*32 + ch] = sl.nblocks * nsets++;
+    sl.bits.assign(size_t(sl.nblocks) * nsets, 0);
+
+    for (int w = 0; w < nwords; w++) {
+        Symbol *st = (*wl)[sl.words[w]];
+        for (int pos = 0; pos < len; pos++) {
+            int off = sl.index[pos*32 + st[pos].symbvalue()];
+            sl.bits[off + w/64] |= uint64_t(1) << (w%64);
+        }
+    }
+    sl.built = true;
+}
+
+const uint64_t *BitDict::letterbits(int len, int pos, int symb) {
+    Slice &sl = slice(len);
+    if (sl.nblocks == 0)
+        return 0;
+    int off = sl.index[pos*32 + symb];
+    if (off < 0)
+        return 0;
+    return &sl.bits[off];
+}
+
+// Intersects the bitsets of the fixed letters of s into result.
+// Returns the matching words, or 0 if a fixed letter never occurs
+// there (nsets is then -1). Otherwise nsets is the number of fixed
+// letters; if it is 0 there is no bitset and every word matches.
+const uint64_t *BitDict::matchwords(Slice &sl, Symbol *s, int len,
+                                    uint64_t *result, int &nsets) {
+    const uint64_t *sets[len];
+    nsets = 0;
+    for (int i = 0; i < len; i++) {
+        if (s[i] != Symbol::empty) {
+            int off = sl.index[i*32 + s[i].symbvalue()];
+            if (off < 0) {
+                nsets = -1;
+                return 0;
+            }
+            sets[nsets++] = &sl.bits[off];
+        }
+    }
+    if (nsets == 0)
+        return 0;
+
+    int n = sl.nblocks;
+    if (nsets == 1)
+        return sets[0];
+    andbits(result, sets[0], sets[1], n);
+    for (int i = 2; i < nsets; i++)
+        andbits(result, result, sets[i], n);
+    return result;
+}
+
+// the symbols at pos of the words in r, which has words in [lo, hi)
+SymbolSet BitDict::lettersat(Slice &sl, const uint64_t *r, int lo, int hi, int pos) {
+    SymbolSet ss = 0;
+    SymbolSet cand = sl.all[pos];
+    for (int ch = 0; cand; ch++, cand >>= 1) {
+        if (!(cand & 1))
+            continue;
+        const uint64_t *b = &sl.bits[sl.index[pos*32 + ch]];
+        if (anybits(r + lo, b + lo, hi - lo))
+            ss |= SymbolSet(1) << ch;
+    }
+    return ss;
+}
+
+SymbolSet BitDict::findpossible(Symbol *s, int len, int pos) {
+    if (len == 1) return wl->allalpha;
+
+    Slice &sl = slice(len);
+    if (sl.nblocks == 0)
+        return 0;
+
+    int n = sl.nblocks, nsets;
+    uint64_t result[n];
+    const uint64_t *r = matchwords(sl, s, len, result, nsets);
+    if (nsets == 0)
+        return sl.all[pos];
+    if (r == 0)
+        return 0;
+
+    // only test the blocks where there are words left
+    int lo = 0, hi = n;
+    while (lo < hi && r[lo] == 0) lo++;
+    while (hi > lo && r[hi-1] == 0) hi--;
+    if (lo == hi)
+        return 0;
+
+    return lettersat(sl, r, lo, hi, pos);
+}
+
+int BitDict::findslot(Symbol *s, int len, SymbolSet *sets) {
+    if (len == 1 || len >= MAXWORDLEN)
+        return Dict::findslot(s, len, sets);
+
+    Slice &sl = slice(len);
+    for (int i = 0; i < len; i++)
+        sets[i] = 0;
+    if (sl.nblocks == 0)
+        return 0;
+
+    int n = sl.nblocks, nsets;
+    uint64_t result[n];
+    const uint64_t *r = matchwords(sl, s, len, result, nsets);
+    if (nsets == 0) {
+        for (int i = 0; i < len; i++)
+            sets[i] = sl.all[i];
+        return sl.words.size();
+    }
+    if (r == 0)
+        return 0;
+
+    int lo = 0, hi = n;
+    while (lo < hi && r[lo] == 0) lo++;
+    while (hi > lo && r[hi-1] == 0) hi--;
+    int count = 0;
+    for (int b = lo; b < hi; b++)
+        count += __builtin_popcountll(r[b]);
+    if (count == 0)
+        return 0;
+
+    if (count <= 16) {
+        // few words left: OR their letters directly
+        for (int b = lo; b < hi; b++) {
+            for (uint64_t bits = r[b]; bits; bits &= bits - 1) {
+                Symbol *st = (*wl)[sl.words[b*64 + __builtin_ctzll(bits)]];
+                for (int i = 0; i < len; i++)
+                    sets[i] |= st[i].getsymbolset();
+            }
+        }
+    } else {
+        for (int i = 0; i < len; i++) {
+            if (s[i] != Symbol::empty)
+                sets[i] = s[i].getsymbolset();
+            else
+                sets[i] = lettersat(sl, r, lo, hi, i);
+        }
+    }
+    return count;
+}
+
+size_t BitDict::memoryusage() {
+    size_t n = 0;
+    for (int len = 0; len < MAXWORDLEN; len++) {
+        Slice &sl = slices[len];
+        n += sl.words.capacity() * sizeof(int) + sl.index.capacity() * sizeof(int)
+            + sl.bits.capacity() * sizeof(uint64_t);
+    }
+    return n;
+}
+
+void BitDict::load(const std::string &fn) {
+    std::cout << "Loading wordlist and building dictionary... " << std::flush;
+
+    wl = new WordList();
+    wl->load(fn);
+
+    int nwords = wl->numwords();
+    for (int i=0; i<nwords; i++)
+        addword((*wl)[i], i);
+    build();
+
+    std::cout << "ok" << std::endl;
+}
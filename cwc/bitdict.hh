@@ -0,0 +1,76 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+
+#ifndef CWC_BITDICT_HH
+#define CWC_BITDICT_HH
+
+#include <vector>
+#include <stdint.h>
+#include "symbol.hh"
+#include "dict.hh"
+#include "wordlist.hh"
+
+/**
+ * Dictionary storing, for every word length, one dense bitset of
+ * words per (position, letter). A query is the AND of the bitsets of
+ * the fixed letters, after which the candidate letters are found by
+ * testing the result against the bitsets of the asked position.
+ *
+ * Slices are built the first time a length is queried, or by build().
+ */
+
+class BitDict : public Dict {
+    struct Slice {
+        Slice() : nblocks(0), built(true) {}
+        std::vector<int> words;       // word list index of each bit
+        std::vector<int> index;       // [pos*32 + symbol] -> offset in bits, or -1
+        std::vector<uint64_t> bits;
+        SymbolSet all[MAXWORDLEN];
+        int nblocks;
+        bool built;
+    };
+    Slice slices[MAXWORDLEN];
+    void buildslice(int len);
+    Slice &slice(int len) {
+        if (!slices[len].built)
+            buildslice(len);
+        return slices[len];
+    }
+    const uint64_t *matchwords(Slice &sl, Symbol *s, int len, uint64_t *result, int &nsets);
+    SymbolSet lettersat(Slice &sl, const uint64_t *r, int lo, int hi, int pos);
+public:
+    WordList *wl = nullptr;
+    BitDict();
+    void addword(Symbol *st, int wordi);
+    void build();
+    int numwords(int len) { return slice(len).words.size(); }
+    int numblocks(int len) { return slice(len).nblocks; }
+    SymbolSet allat(int len, int pos) { return numblocks(len) ? slices[len].all[pos] : 0; }
+    Symbol *word(int len, int i) { return (*wl)[slice(len).words[i]]; }
+    const uint64_t *letterbits(int len, int pos, int symb);
+    SymbolSet findpossible(Symbol *s, int len, int pos);
+    int findslot(Symbol *s, int len, SymbolSet *sets);
+    void load(const std::string &fn);
+    size_t memoryusage();
+};
+
+#endif // CWC_BITDICT_HH
@@ -0,0 +1,118 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+
+#include "cacheddict.hh"
+
+//////////////////////////////////////////////////////////////////////
+// cacheddict
+
+CachedDict::CachedDict(Dict &thedict, int cap)
+    : d(thedict), capacity(cap), hand(0), hits(0), misses(0), evictions(0) {
+    if (capacity < 1)
+        capacity = 1;
+    entries.reserve(capacity);
+    index.reserve(capacity);
+}
+
+// 5 bits for the length, 5 for the position and 5 per symbol, twelve
+// symbols to a word (ten in the first).
+CachedDict::Key CachedDict::makekey(Symbol *s, int len, int pos) {
+    Key k = {{ uint64_t(len) | uint64_t(pos) << 5, 0, 0 }};
+    for (int i = 0; i < len; i++) {
+        int bit = 10 + i * 5;
+        k.w[bit / 60] |= uint64_t(s[i].symbvalue()) << (bit % 60);
+    }
+    return k;
+}
+
+size_t CachedDict::KeyHash::operator()(const Key &k) const {
+    uint64_t h = k.w[0] * 0x9e3779b97f4a7c15ULL;
+    h = (h ^ (h >> 29) ^ k.w[1]) * 0xbf58476d1ce4e5b9ULL;
+    h = (h ^ (h >> 32) ^ k.w[2]) * 0x94d049bb133111ebULL;
+    return h ^ (h >> 31);
+}
+
+void CachedDict::load(const std::string &fn) {
+    d.load(fn);
+    clear();
+}
+
+void CachedDict::clear() {
+    entries.clear();
+    index.clear();
+    hand = 0;
+}
+
+SymbolSet CachedDict::findpossible(Symbol *s, int len, int pos) {
+    if (len >= MAXWORDLEN)
+        return d.findpossible(s, len, pos);
+
+    Key k = makekey(s, len, pos);
+    std::unordered_map<Key, int, KeyHash>::iterator i = index.find(k);
+    if (i != index.end()) {
+        hits++;
+        Entry &e = entries[i->second];
+        e.referenced = true;
+        return e.ss;
+    }
+
+    misses++;
+    SymbolSet ss = d.findpossible(s, len, pos);
+
+    int slot;
+    if (entries.size() < capacity) {
+        slot = entries.size();
+        entries.push_back(Entry());
+    } else {
+        // advance the clock hand to an entry not used since last pass
+        while (entries[hand].referenced) {
+            entries[hand].referenced = false;
+            hand = (hand + 1) % capacity;
+        }
+        slot = hand;
+        hand = (hand + 1) % capacity;
+        index.erase(entries[slot].key);
+        evictions++;
+    }
+    Entry &e = entries[slot];
+    e.key = k;
+    e.ss = ss;
+    e.referenced = false;
+    index[k] = slot;
+    return ss;
+}
+
+size_t CachedDict::memoryusage() {
+    // the cache only, the dictionary behind it counts for itself; each
+    // map node is roughly a key, a value and a next pointer
+    return entries.capacity() * sizeof(Entry)
+        + index.bucket_count() * sizeof(void*)
+        + index.size() * (sizeof(Key) + sizeof(int) + sizeof(void*));
+}
+
+void CachedDict::report(std::ostream &os) {
+    long total = hits + misses;
+    os << "Dictionary cache: " << hits << " hits, " << misses << " misses";
+    if (total)
+        os << " (" << (hits * 100.0 / total) << "% hits)";
+    os << ", " << evictions << " evictions" << std::endl;
+}
@@ -0,0 +1,74 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+
+#ifndef CWC_CACHEDDICT_HH
+#define CWC_CACHEDDICT_HH
+
+#include <vector>
+#include <unordered_map>
+#include <iostream>
+#include <stdint.h>
+#include "symbol.hh"
+#include "dict.hh"
+
+/**
+ * Dict decorator remembering the answers of another Dict. Queries are
+ * keyed by the packed pattern, length and position. The cache holds a
+ * fixed number of answers and replaces them with the CLOCK policy.
+ */
+
+class CachedDict : public Dict {
+    struct Key {
+        uint64_t w[3];
+        bool operator==(const Key &k) const {
+            return w[0] == k.w[0] && w[1] == k.w[1] && w[2] == k.w[2];
+        }
+    };
+    struct KeyHash {
+        size_t operator()(const Key &k) const;
+    };
+    struct Entry {
+        Key key;
+        SymbolSet ss;
+        bool referenced;
+    };
+
+    Dict &d;
+    size_t capacity;
+    std::vector<Entry> entries;
+    std::unordered_map<Key, int, KeyHash> index;
+    size_t hand;
+
+    static Key makekey(Symbol *s, int len, int pos);
+public:
+    long hits, misses, evictions;
+
+    CachedDict(Dict &thedict, int capacity = 65536);
+    void load(const std::string &fn);
+    SymbolSet findpossible(Symbol *s, int len, int pos);
+    int findslot(Symbol *s, int len, SymbolSet *sets) { return d.findslot(s, len, sets); }
+    void clear();
+    size_t memoryusage();
+    void report(std::ostream &os);
+};
+
+#endif // CWC_CACHEDDICT_HH
@@ -34,6 +34,7 @@
 #include <set>
 #include <vector>
 #include <list>
+#include <algorithm>
 
 #include "timer.hh"
 #include "symbol.hh"
@@ -76,27 +77,74 @@ void Walker::backToOneOf(int no[], int n) {
 
 void Walker::backToOneOf(Backtracker &bt) {
     backward(false); // dont save current
-    while (!bt.stopHere(current))
+    // with no point left to stop at, stop at the first cell
+    while (!cellno.empty() && !bt.stopHere(current))
         backward(true); // save all we skip
 }
 
 void Walker::forward() {
     if (inited) {
         cellno.push_back(current);
+        filled(current);
         do step_forward(); while (!g.cellno(current).isempty());
     } else {
         init();
         inited = true;
     }
+    if (stepno.empty())
+        stepno.assign(g.numcells(), -1);
+    stepno[current] = cellno.size();
+}
+
+int Walker::stepOf(int c) {
+    int step = stepno.empty() ? -1 : stepno[c];
+    return (step >= 0 && step < stepCount() && cellAt(step) == c) ? step : -1;
 }
 
 void Walker::backward(bool savepreferred) {
-    if (!g.cellno(current).isoutside())
+    if (!g.cellno(current).isoutside()) {
         g.cellno(current).clear(savepreferred);
+        cleared(current);
+    }
     current = cellno.back();
     cellno.pop_back();
 }
 
+void Walker::rewind(bool savepreferred) {
+    if (!inited) return;
+    for (;;) {
+        if (g.cellno(current).isfilled()) {
+            g.cellno(current).clear(savepreferred);
+            cleared(current);
+        }
+        if (cellno.empty()) break;
+        current = cellno.back();
+        cellno.pop_back();
+    }
+    // the cells skipped on backjumps kept theirs
+    if (!savepreferred) {
+        int ncells = g.numcells();
+        for (int c = 0; c < ncells; c++)
+            if (g.cellno(c).isempty())
+                g.cellno(c).clear(false);
+    }
+    inited = false;
+}
+
+void Walker::force(int c) {
+    if (forcedby.empty())
+        forcedby.assign(g.numcells(), -1);
+    forcedby[c] = current;
+    limit--;
+    filled(c);
+}
+
+void Walker::unforce(int c) {
+    forcedby[c] = -1;
+    limit++;
+    cleared(c);
+}
+
 bool Walker::moresteps() {
     return (cellno.size() + 1) < unsigned(limit);
 }
@@ -104,7 +152,6 @@ bool Walker::moresteps() {
 void Walker::findnext() {
     int ncells = g.numcells();
     for (int i = 0; i < ncells; i++) {
-        std::cout << i << " " << g.cellno(i).getsymbol().symbvalue() << std::endl;
         if (g.cellno(i).isempty()) {
             current = i;
             return;
@@ -130,31 +177,81 @@ void PrefixWalker::step_forward() {
 FloodWalker::FloodWalker(Grid &g) : Walker(g) {
 }
 
-void FloodWalker::step_forward() {
-    std::vector<int>::iterator i;
-    for (i = cellno.begin(); i != cellno.end(); i++) {
-        int cno = *i;
-
-        int nwords = g.cellno(cno).numwords();
+void FloodWalker::init() {
+    int ncells = g.numcells();
+    first.assign(ncells + 1, 0);
+    adjacent.clear();
+    for (int c = 0; c < ncells; c++) {
+        first[c] = adjacent.size();
+        Cell &thecell = g.cellno(c);
+        int nwords = thecell.numwords();
         for (int w = 0; w < nwords; w++) {
-            Cell &thecell = g.cellno(cno);
             WordBlock &wb = thecell.getwordblock(w);
             int pos = thecell.getpos(w);
-            int len = wb.length();
+            if (pos > 0)
+                adjacent.push_back(wb.getcellno(pos - 1));
+            if (pos < wb.length() - 1)
+                adjacent.push_back(wb.getcellno(pos + 1));
+        }
+    }
+    first[ncells] = adjacent.size();
+    open.assign(ncells, false);
+    for (int c = 0; c < ncells; c++)
+        open[c] = g.cellno(c).isempty();
+    walked.clear();
+    walkstep.assign(ncells, -1);
+    nopen.assign(ncells, 0);
+    frontier.clear();
+    findnext();
+}
 
-            if (pos > 0) {
-                int cellbefore = wb.getcellno(pos-1);
-                if (g.cellno(cellbefore).isempty()) {
-                    current = cellbefore;
-                    return;
-                }
-            }
-            if (pos < len-1) {
-                int cellafter = wb.getcellno(pos + 1);
-                if (g.cellno(cellafter).isempty()) {
-                    current = cellafter;
-                    return;
-                }
+// Cells next to each other are so in the same word, so c is next to
+// the cells next to it.
+void FloodWalker::update(int c) {
+    if (open.empty()) return;
+    bool now = g.cellno(c).isempty();
+    if (now == open[c]) return;
+    open[c] = now;
+    for (int i = first[c]; i < first[c + 1]; i++) {
+        int h = adjacent[i];
+        if (walkstep[h] < 0) continue;
+        nopen[h] += now ? 1 : -1;
+        if (nopen[h] == 0)
+            frontier.erase(walkstep[h]);
+        else if (now && nopen[h] == 1)
+            frontier.insert(walkstep[h]);
+    }
+}
+
+void FloodWalker::sync() {
+    size_t n = cellno.size();
+    while (walked.size() > n || (walked.size() == n && n && walked.back() != cellno.back())) {
+        int h = walked.back();
+        walked.pop_back();
+        if (nopen[h])
+            frontier.erase(walkstep[h]);
+        walkstep[h] = -1;
+        nopen[h] = 0;
+    }
+    if (walked.size() == n) return;
+    int h = cellno.back();
+    walkstep[h] = walked.size();
+    walked.push_back(h);
+    for (int i = first[h]; i < first[h + 1]; i++)
+        if (open[adjacent[i]])
+            nopen[h]++;
+    if (nopen[h])
+        frontier.insert(walkstep[h]);
+}
+
+void FloodWalker::step_forward() {
+    sync();
+    if (!frontier.empty()) {
+        int h = walked[*frontier.begin()];
+        for (int i = first[h]; i < first[h + 1]; i++) {
+            if (open[adjacent[i]]) {
+                current = adjacent[i];
+                return;
             }
         }
     }
@@ -162,10 +259,103 @@ void FloodWalker::step_forward() {
     findnext();
 }
 
+//////////////////////////////////////////////////////////////////////
+// class mrv_walker
+
+MRVWalker::MRVWalker(Grid &g, Dict &thedict) : Walker(g), d(thedict) {
+}
+
+// fewer letters first, then more words, then the lower cell number
+void MRVWalker::update(int c) {
+    if (keyof[c] >= 0) {
+        buckets[keyof[c]].erase(c);
+        keyof[c] = -1;
+    }
+    Cell &cell = g.cellno(c);
+    if (!cell.isempty()) return;
+    int degree = std::min(cell.numwords(), maxdegree - 1);
+    int key = numones(cell.findpossible(d)) * maxdegree + maxdegree - 1 - degree;
+    buckets[key].insert(c);
+    keyof[c] = key;
+}
+
+void MRVWalker::updatewords(int c) {
+    Cell &cell = g.cellno(c);
+    int nwords = cell.numwords();
+    for (int w = 0; w < nwords; w++) {
+        WordBlock &wb = cell.getwordblock(w);
+        int len = wb.length();
+        for (int p = 0; p < len; p++)
+            update(wb.getcellno(p));
+    }
+}
+
+void MRVWalker::init() {
+    buckets.assign((g.alphabet().numletters() + 1) * maxdegree, std::set<int>());
+    keyof.assign(g.numcells(), -1);
+    int ncells = g.numcells();
+    for (int c = 0; c < ncells; c++)
+        update(c);
+    step_forward();
+}
+
+void MRVWalker::step_forward() {
+    for (unsigned k = 0; k < buckets.size(); k++) {
+        if (!buckets[k].empty()) {
+            current = *buckets[k].begin();
+            buckets[k].erase(buckets[k].begin());
+            keyof[current] = -1;
+            return;
+        }
+    }
+    throw error("No empty cells");
+}
+
+void MRVWalker::filled(int c) {
+    updatewords(c);
+}
+
+void MRVWalker::cleared(int c) {
+    updatewords(c);
+}
+
 //////////////////////////////////////////////////////////////////////
 // class backtracker
 
-Backtracker::Backtracker(Grid &thegrid) : g(thegrid) {
+Backtracker::Backtracker(Grid &thegrid) : g(thegrid), stamp(0) {
+}
+
+// The cells on the walk whose letters rule out letters of c: the
+// filled cells of its words, where a cell filled by propagation stands
+// for the filled cells of its own words in turn.
+void Backtracker::culprits(Walker &w, int c, std::vector<int> &cells) {
+    cells.clear();
+    if (seen.size() != size_t(g.numcells()) || ++stamp == 0) {
+        seen.assign(g.numcells(), 0);
+        stamp = 1;
+    }
+    seen[c] = stamp;
+    todo.clear();
+    todo.push_back(c);
+    while (!todo.empty()) {
+        Cell &cell = g.cellno(todo.back());
+        todo.pop_back();
+        int nwords = cell.numwords();
+        for (int wno = 0; wno < nwords; wno++) {
+            WordBlock &wb = cell.getwordblock(wno);
+            int len = wb.length();
+            int pos = cell.getpos(wno);
+            for (int p = 0; p < len; p++) {
+                int x = wb.getcellno(p);
+                if (p == pos || !wb.getcell(p).isfilled() || seen[x] == stamp) continue;
+                seen[x] = stamp;
+                if (w.origin(x) != x)
+                    todo.push_back(x);
+                else
+                    cells.push_back(x);
+            }
+        }
+    }
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -178,6 +368,155 @@ void NaiveBacktracker::backtrack(Walker &w) {
     w.backward(false);
 }
 
+//////////////////////////////////////////////////////////////////////
+// class conflict_backtracker
+//
+// Steps deeper than the current one have empty conflict sets: a jump
+// clears the sets of all the steps it leaves.
+
+ConflictBacktracker::ConflictBacktracker(Grid &thegrid)
+    : Backtracker(thegrid), nwords(0), target(-1), nogoods(0), nodes(0) {
+}
+
+void ConflictBacktracker::init() {
+    nwords = (g.numcells() + 63) / 64;
+    conflicts.assign(size_t(g.numcells()) * nwords, 0);
+    firstnode.assign(g.numcells(), -1);
+}
+
+// add to conf the steps below that filled the culprits of c
+void ConflictBacktracker::addcells(Walker &w, int c, uint64_t *conf, int below) {
+    culprits(w, c, cells);
+    for (unsigned i = 0; i < cells.size(); i++) {
+        int step = w.stepOf(cells[i]);
+        if (step >= 0 && step < below)
+            conf[step / 64] |= uint64_t(1) << (step % 64);
+    }
+}
+
+// A conflict set is a nogood: no fill has all its steps read as they
+// do now. It is filed under the word of the latest step holding most
+// of it, so that step reading as it does brings it back.
+void ConflictBacktracker::learn(Walker &w, uint64_t *conf, int culprit, long cost) {
+    Cell &cell = g.cellno(w.cellAt(culprit));
+    int nwordblocks = cell.numwords();
+    WordBlock *best = 0;
+    uint32_t bestpositions = 0;
+    for (int wno = 0; wno < nwordblocks; wno++) {
+        WordBlock &wb = cell.getwordblock(wno);
+        int len = wb.length();
+        uint32_t positions = 0;
+        for (int p = 0; p < len; p++) {
+            int step = w.stepOf(w.origin(wb.getcellno(p)));
+            if (step >= 0 && step <= culprit && (conf[step / 64] >> (step % 64)) & 1)
+                positions |= 1u << p;
+        }
+        if (!best || __builtin_popcount(positions) > __builtin_popcount(bestpositions)) {
+            best = &wb;
+            bestpositions = positions;
+        }
+    }
+    if (!best) return;
+
+    std::vector<int> outside;
+    for (int step = 0; step <= culprit; step++) {
+        if (!((conf[step / 64] >> (step % 64)) & 1)) continue;
+        int c = w.cellAt(step);
+        int len = best->length();
+        int p = 0;
+        while (p < len && best->getcellno(p) != c)
+            p++;
+        if (p == len)
+            outside.push_back(c);
+    }
+    nogoods->add(g, *best, bestpositions, outside, cost);
+}
+
+void ConflictBacktracker::backtrack(Walker &w) {
+    if (!nwords)
+        init();
+    int cstep = w.stepCount() - 1;
+    uint64_t *conf = row(cstep);
+    int cno = w.getCurrent();
+
+    // whatever came up from below; without it, the cell had no letters
+    // and findpossible() will say so again
+    bool learned = false;
+    for (int i = 0; i <= cstep / 64 && !learned; i++)
+        learned = conf[i] != 0;
+    addcells(w, cno, conf, cstep);
+
+    // the latest culprit; with none, the previous step
+    int jump = cstep - 1;
+    for (int i = cstep / 64; i >= 0; i--) {
+        if (conf[i]) {
+            jump = i * 64 + 63 - __builtin_clzll(conf[i]);
+            if (nogoods && learned)
+                learn(w, conf, jump, nodes - firstnode[cstep]);
+            break;
+        }
+    }
+    if (jump >= 0) {
+        uint64_t *to = row(jump);
+        for (int i = 0; i <= jump / 64; i++)
+            to[i] |= conf[i];
+        to[jump / 64] &= ~(uint64_t(1) << (jump % 64));
+    }
+    for (int step = jump + 1; step <= cstep; step++) {
+        uint64_t *r = row(step);
+        for (int i = 0; i < nwords; i++)
+            r[i] = 0;
+        firstnode[step] = -1;
+    }
+
+    target = w.cellAt(jump < 0 ? 0 : jump);
+    w.backToOneOf(*this);
+}
+
+// the letter of this step failed because of the culprits of c
+void ConflictBacktracker::wipeout(Walker &w, int c) {
+    if (!nwords)
+        init();
+    int cstep = w.stepCount() - 1;
+    addcells(w, c, row(cstep), cstep);
+}
+
+void ConflictBacktracker::rewind(bool keeplearned) {
+    // conflict sets are by step, nogoods by cell
+    nwords = 0;
+    if (nogoods && !keeplearned)
+        nogoods->clear();
+}
+
+// A pruned letter failed because of the nogood it completed, so the
+// cells of the nogood join the conflict set of this step.
+bool ConflictBacktracker::prune(Walker &w) {
+    if (!nogoods) return false;
+    if (!nwords)
+        init();
+    int cstep = w.stepCount() - 1;
+    if (firstnode[cstep] < 0)
+        firstnode[cstep] = nodes;
+    nodes++;
+
+    Cell &cell = g.cellno(w.getCurrent());
+    int nwordblocks = cell.numwords();
+    for (int wno = 0; wno < nwordblocks; wno++) {
+        WordBlock &wb = cell.getwordblock(wno);
+        found.clear();
+        if (nogoods->find(g, wb, cell.getpos(wno), found)) {
+            uint64_t *conf = row(cstep);
+            for (unsigned i = 0; i < found.size(); i++) {
+                int step = w.stepOf(w.origin(found[i]));
+                if (step >= 0 && step < cstep)
+                    conf[step / 64] |= uint64_t(1) << (step % 64);
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
 //////////////////////////////////////////////////////////////////////
 // class smart_backtracker
 //
@@ -203,19 +542,9 @@ void SmartBacktracker::backtrack(Walker &w) {
 
     int cno = w.getCurrent();
 
-    Cell &c = g.cellno(cno);
-    int nwords = c.numwords();
-    for (int wno = 0; wno < nwords; wno++) {
-        WordBlock &wb = c.getwordblock(wno);
-        int len = wb.length();
-
-        int pos = c.getpos(wno);
-        for (int p = 0; p < len; p++) {
-            if ((p!=pos)&&(wb.getcell(p).isfilled()))
-                bt_points.push_back(cpair(cpos, wb.getcellno(p)));
-        }
-
-    }
+    culprits(w, cno, cells);
+    for (unsigned i = 0; i < cells.size(); i++)
+        bt_points.push_back(cpair(cpos, cells[i]));
 
     if (setup.debuginfo) {
         std::cout << "BTSET:" << std::endl;
@@ -227,6 +556,17 @@ void SmartBacktracker::backtrack(Walker &w) {
     w.backToOneOf(*this);
 }
 
+// A letter that propagation rejected failed as if the next cell had
+// been a dead end, so its points are kept as that dead end's would be.
+void SmartBacktracker::wipeout(Walker &w, int c) {
+    int cpos = w.stepCount();
+    int cno = w.getCurrent();
+    culprits(w, c, cells);
+    for (unsigned i = 0; i < cells.size(); i++)
+        if (cells[i] != cno)
+            bt_points.push_back(cpair(cpos + 1, cells[i]));
+}
+
 bool SmartBacktracker::stopHere(int p) {
     for (std::list<cpair>::iterator i = bt_points.begin();
          i != bt_points.end();
@@ -246,29 +586,99 @@ bool SmartBacktracker::stopHere(int p) {
 
 Compiler::Compiler(Grid &thegrid, Walker &thewalker,
                    Backtracker &thebacktracker, Dict &thedict)
-    : g(thegrid), w(thewalker), bt(thebacktracker), d(thedict) {
+    : g(thegrid), w(thewalker), bt(thebacktracker), d(thedict), cancel(0),
+      splitter(0), splitdepth(0), floor(1), solutions(0), nodes(0), backtracks(0) {
     g.verbose = verbose = false;
     findall = false;
+    propagation = false;
+}
+
+void Compiler::split(SymbolSet ss) {
+    std::vector<Symbol> prefix;
+    int nfilled = w.stepCount() - 1;
+    for (int i = 0; i < nfilled; i++)
+        prefix.push_back(g(w.cellAt(i)).getsymbol());
+    prefix.push_back(Symbol::empty);
+    for (SymbolSet bit = pickbit(ss, rng); bit; bit = pickbit(ss, rng)) {
+        prefix.back() = Symbol::symbolbit(bit);
+        splitter->split(prefix);
+    }
 }
 
 #define success true
 #define failure false
 
-// upon failure, walker is backed up to some cell
-// the reclevel trying to compute this cell catches it
-// and others will return.
+void Compiler::queuewords(int c) {
+    Cell &cell = g(c);
+    int nwords = cell.numwords();
+    for (int i = 0; i < nwords; i++) {
+        WordBlock *wb = &cell.getwordblock(i);
+        if (std::find(queue.begin(), queue.end(), wb) == queue.end())
+            queue.push_back(wb);
+    }
+}
+
+// Recheck the open cells of every word that changed, starting with
+// the words of c. A cell with a single possible letter gets it, which
+// changes its words in turn; the cells filled go on the trail.
+bool Compiler::propagate(int c) {
+    queue.clear();
+    queuewords(c);
+    while (!queue.empty()) {
+        WordBlock &wb = *queue.front();
+        queue.pop_front();
+        int len = wb.length();
+        for (int p = 0; p < len; p++) {
+            Cell &cell = wb.getcell(p);
+            if (!cell.isempty()) continue;
+            SymbolSet ss = cell.findpossible(d);
+            if (!ss) {
+                bt.wipeout(w, wb.getcellno(p));
+                return failure;
+            }
+            if (ss & (ss - 1)) continue;
+            int x = wb.getcellno(p);
+            cell.setsymbol(Symbol::symbolbit(ss));
+            trail.push_back(x);
+            w.force(x);
+            queuewords(x);
+        }
+    }
+    return success;
+}
+
+// clear the cells propagated since the trail was mark long
+void Compiler::unforce(unsigned mark) {
+    while (trail.size() > mark) {
+        int x = trail.back();
+        trail.pop_back();
+        g(x).setsymbol(Symbol::empty);
+        w.unforce(x);
+    }
+}
 
-Timer dtimer;
+// The search keeps one frame per filled cell on an explicit stack, in
+// the order a recursive search would. Upon failure the walker is backed
+// up to some cell; the frame trying to compute this cell catches it and
+// the ones above it are dropped.
 
-bool Compiler::compile_rest(double rejected) {
-    int c = w.getCurrent();
+void Compiler::enter() {
+    if (stopping()) {
+        step = returning;
+        return;
+    }
+    Frame f;
+    f.cell = w.getCurrent();
+    f.rejected = stack.empty() ? 0 : stack.back().rejected;
+    f.mark = trail.size();
+    int c = f.cell;
     if (verbose)
         std::cout << "attempting to find solution for " << c << std::endl;
     SymbolSet ss = g(c).findpossible(d);
     int npossible = numones(ss);
-    rejected += (numalpha-double(npossible)) * pow(numalpha, numcells - w.stepCount());
+    f.rejected += (numalpha-double(npossible)) * pow(numalpha, numcells - w.stepCount());
     if (verbose)
-        dumpset(ss);
+        dumpset(ss, g.alphabet());
 
     SymbolSet bit;
     // use preferred if any
@@ -280,60 +690,217 @@ bool Compiler::compile_rest(double rejected) {
             ss &= ~bit; // remove bit from set
         }
         else
-            bit = pickbit(ss);
+            bit = pickbit(ss, rng);
     } else
-        bit = pickbit(ss);
-    for (; bit; bit=pickbit(ss)) {
-        Symbol s = Symbol::symbolbit(bit);
-        g(c).setsymbol(s);
-        if (w.moresteps()) {
-            w.forward();
-            if (compile_rest(rejected) == success) return success;
-            if (w.getCurrent() != c) return failure; // catch if ==
-            // cout << "continue at " << c << endl;
-            rejected += pow(numalpha, numcells - w.stepCount());
-        } else {
-            this->rejected = rejected;
-            return success;
+        bit = pickbit(ss, rng);
+    if (splitter && bit && w.stepCount() <= splitdepth && w.moresteps()) {
+        // search the first branch here and let others take the rest
+        split(ss);
+        ss = 0;
+    }
+    f.ss = ss;
+    f.bit = bit;
+    stack.push_back(f);
+    step = trying;
+}
+
+// try the next letter of the top frame
+void Compiler::tryletter() {
+    Frame &f = stack.back();
+    int c = f.cell;
+    if (!f.bit) {
+        if (w.stepCount() > floor) {
+            // a cell that had fills below it is no dead end, so counting
+            // all of them cannot jump back
+            if (findall) w.backward(false);
+            else bt.backtrack(w);
+            backtracks++;
+            int cur = w.getCurrent();
+            if (verbose)
+                std::cout << "return to " << cur << " from " << c << std::endl;
         }
-        g(c).setsymbol(Symbol::empty);
+        stack.pop_back();
+        step = returning;
+        return;
     }
-    if (w.stepCount() > 1) {
-        bt.backtrack(w);
-        int cur = w.getCurrent();
-        if (verbose)
-            std::cout << "return to " << cur << " from " << c << std::endl;
+    Symbol s = Symbol::symbolbit(f.bit);
+    g(c).setsymbol(s);
+    nodes++;
+    f.mark = trail.size();
+    if (!propagation && bt.prune(w)) {
+        // a known dead end next to it
+        f.rejected += pow(numalpha, numcells - w.stepCount());
+    } else if (propagation && !propagate(c)) {
+        // some open cell has no letter left
+        unforce(f.mark);
+        f.rejected += pow(numalpha, numcells - w.stepCount());
+    } else if (w.moresteps()) {
+        w.forward();
+        step = entering;
+        return;
+    } else {
+        this->rejected = f.rejected;
+        if (!findall) {
+            step = finished;
+            return;
+        }
+        solutions++;
+        unforce(f.mark);
     }
-    return failure;
+    g(c).setsymbol(Symbol::empty);
+    f.bit = pickbit(f.ss, rng);
 }
 
-bool Compiler::compile() {
-    dtimer.reset(); dtimer.start();
+// the search below the top frame failed
+void Compiler::catchfailure() {
+    Frame &f = stack.back();
+    unforce(f.mark);
+    if (stopping() || w.getCurrent() != f.cell) {
+        // not for this frame, catch if ==
+        stack.pop_back();
+        return;
+    }
+    // cout << "continue at " << c << endl;
+    f.rejected += pow(numalpha, numcells - w.stepCount());
+    g(f.cell).setsymbol(Symbol::empty);
+    f.bit = pickbit(f.ss, rng);
+    step = trying;
+}
+
+void Compiler::start(const std::vector<Symbol> &prefix) {
     w.forward();
     numcells = g.numopen();
-    numalpha = Symbol::numalpha();
-    return compile_rest();
+    numalpha = g.alphabet().numletters();
+    solutions = 0;
+    nodes = 0;
+    backtracks = 0;
+    trail.clear();
+    stack.clear();
+    stack.reserve(numcells + 1);
+    step = entering;
+    // the walker steps through the cells of the prefix as it did when
+    // the branch was split off, propagating the same cells
+    floor = prefix.size() + 1;
+    for (unsigned i = 0; i < prefix.size(); i++) {
+        g(w.getCurrent()).setsymbol(prefix[i]);
+        if (propagation && !propagate(w.getCurrent())) {
+            step = returning;
+            return;
+        }
+        if (!w.moresteps()) {
+            // propagation filled the rest, as in tryletter
+            rejected = 0;
+            if (!findall) {
+                step = finished;
+                return;
+            }
+            solutions++;
+            step = returning;
+            return;
+        }
+        w.forward();
+    }
+}
+
+void Compiler::rewind(bool keeppreferred, bool keeplearned) {
+    unforce(0);
+    w.rewind(keeppreferred);
+    bt.rewind(keeplearned);
+    stack.clear();
+    step = exhausted;
+}
+
+Compiler::Status Compiler::resume(long budget) {
+    long stop = nodes + budget;
+    for (;;) {
+        switch (step) {
+        case entering:
+            enter();
+            break;
+        case trying:
+            if (budget >= 0 && nodes >= stop && stack.back().bit)
+                return suspended;
+            tryletter();
+            break;
+        case returning:
+            if (stack.empty()) {
+                step = exhausted;
+                return exhausted;
+            }
+            catchfailure();
+            break;
+        default:
+            return Status(step);
+        }
+    }
+}
+
+bool Compiler::compile() {
+    return compile(std::vector<Symbol>());
+}
+
+bool Compiler::compile(const std::vector<Symbol> &prefix) {
+    start(prefix);
+    Status st = resume();
+    return findall ? solutions > 0 : st == filled;
+}
+
+Compiler::Result Compiler::compile(Clock::time_point deadline, std::atomic<bool> *cancelflag,
+                                   Progress *progress) {
+    // how often the clock is read
+    const long slice = 1024;
+    std::atomic<bool> *saved = cancel;
+    if (cancelflag)
+        cancel = cancelflag;
+    Clock::time_point report = Clock::now();
+    if (progress)
+        report += std::chrono::milliseconds(progress->interval);
+
+    start();
+    Status st;
+    bool late = false;
+    while ((st = resume(slice)) == suspended) {
+        Clock::time_point now = Clock::now();
+        if (now >= deadline) {
+            late = true;
+            break;
+        }
+        if (progress && now >= report) {
+            progress->progress(nodes, backtracks, getdepth());
+            report = now + std::chrono::milliseconds(progress->interval);
+        }
+    }
+
+    Result r;
+    r.nodes = nodes;
+    r.backtracks = backtracks;
+    if (findall ? solutions > 0 : st == filled)
+        r.outcome = solved;
+    else if (late)
+        r.outcome = timeout;
+    else if (stopping())
+        r.outcome = cancelled;
+    else
+        r.outcome = complete() ? unsat : incomplete;
+    if (st != filled && (late || stopping()))
+        rewind();
+    cancel = saved;
+    return r;
 }
 
 //////////////////////////////////////////////////////////////////////
 // main
 
-void dumpset(SymbolSet ss) {
-    int i,n;
-    std::cout << '{';
-    for (i=1, n = 0; i; i<<=1, n++) {
-        if (ss&i)
-            std::cout << Symbol::alphabet[n];
-    }
-    std::cout << '}' << std::endl;
+void dumpset(SymbolSet ss, const Alphabet &a) {
+    std::cout << '{' << a.letters(ss) << '}' << std::endl;
 }
 
-void dumpsymbollist(Symbol *s, int n) {
+void dumpsymbollist(Symbol *s, int n, const Alphabet &a) {
     for (int i=0;i<n;i++) {
         if (s[i] == Symbol::empty)
             std::cout << '-';
         else
-            std::cout << s[i];
+            std::cout << a.letter(s[i]);
     }
     std::cout << std::endl;
 }
@@ -24,9 +24,14 @@
 
 #include "main.hh"
 #include "grid.hh"
+#include "nogood.hh"
 
 #include <map>
 #include <list>
+#include <set>
+#include <deque>
+#include <atomic>
+#include <chrono>
 
 //////////////////////////////////////////////////////////////////////
 
@@ -41,6 +46,8 @@ protected:
     bool current_oneof(int *no, int n);
     int limit;
     bool inited;
+    std::vector<int> forcedby;
+    std::vector<int> stepno; // by cell, valid for cells on the walk
 
 public:
     Walker(Grid &thegrid);
@@ -52,7 +59,19 @@ public:
     Cell &currentCell();
     void forward();
     void backward(bool savepreferred = false);
+    // clear the cells of the walk and start over at the next forward()
+    void rewind(bool savepreferred = false);
     int stepCount() { return cellno.size() + 1; }
+    // the cell filled at a step, counting from 0; the last is current
+    int cellAt(int step) { return step < int(cellno.size()) ? cellno[step] : current; }
+    // cell c was filled, or cleared, by someone else while the walker
+    // stood on the cell that caused it; the walker will not step there
+    void force(int c);
+    void unforce(int c);
+    // the cell on the walk whose fill decided the letter of c
+    int origin(int c) { return (forcedby.empty() || forcedby[c] < 0) ? c : forcedby[c]; }
+    // the step at which c was filled or is current, -1 if not on the walk
+    int stepOf(int c);
 
 protected:
     /**
@@ -75,6 +94,12 @@ protected:
      * find the first free cell in the grid.
      */
     virtual void findnext();
+    /**
+     * called as the walker leaves cell c filled, and after it has
+     * cleared cell c on the way back.
+     */
+    virtual void filled(int /*c*/) {}
+    virtual void cleared(int /*c*/) {}
 public:
     bool moresteps();
 };
@@ -87,11 +112,62 @@ protected:
     virtual void step_forward();
 };
 
+/**
+ * Steps to an open cell next to the earliest filled cell on the walk
+ * that has one, in the order of its words, before then after; with
+ * none, to the first open cell.
+ *
+ * The walk as of the last step is mirrored with, for each of its
+ * cells, how many cells next to it are open; the frontier holds the
+ * steps of those with any. Filling or clearing a cell only changes
+ * the counts of the cells next to it, and the walk only loses cells
+ * from its end before it gains the next. The frontier is a sorted set,
+ * so a step costs time logarithmic in the length of the walk, plus a
+ * scan of the cells when the flood has to start somewhere new.
+ */
+
 class FloodWalker : public Walker {
+    // the cells next to each cell, in the order they are tried
+    std::vector<int> first, adjacent;
+    std::vector<bool> open;     // as of the last filled() or cleared()
+    std::vector<int> walked;
+    std::vector<int> walkstep;  // by cell, its index in walked or -1
+    std::vector<int> nopen;     // by cell on walked
+    std::set<int> frontier;
+    void update(int c);
+    void sync();
 public:
     FloodWalker(Grid &g);
 protected:
-    void step_forward();
+    void init() override;
+    void step_forward() override;
+    void filled(int c) override { update(c); }
+    void cleared(int c) override { update(c); }
+};
+
+/**
+ * Always steps to the open cell with the fewest possible letters, and
+ * of those to one in the most words, so that dead ends show up as soon
+ * as they are made.
+ *
+ * The open cells sit in buckets by that key. Filling or clearing a cell
+ * only changes the cells of its words, so only those move.
+ */
+
+class MRVWalker : public Walker {
+    Dict &d;
+    static const int maxdegree = 4;
+    std::vector<std::set<int> > buckets;
+    std::vector<int> keyof; // -1 when not queued
+    void update(int c);
+    void updatewords(int c);
+public:
+    MRVWalker(Grid &g, Dict &thedict);
+protected:
+    void init() override;
+    void step_forward() override;
+    void filled(int c) override;
+    void cleared(int c) override;
 };
 
 //////////////////////////////////////////////////////////////////////
@@ -99,6 +175,10 @@ protected:
 class Backtracker {
 protected:
     Grid &g;
+    std::vector<unsigned> seen; // by cell, == stamp when met
+    unsigned stamp;
+    std::vector<int> todo;
+    void culprits(Walker &w, int c, std::vector<int> &cells);
 public:
     Backtracker(Grid &thegrid);
     virtual ~Backtracker() {}
@@ -106,6 +186,18 @@ public:
     // a cell where a new solution should be tried.
     virtual void backtrack(Walker &w) =  0;
     virtual bool stopHere(int p) = 0;
+    // false if backtrack() may jump past a cell that still had a fill
+    // below it, so that running out of letters proves nothing
+    virtual bool complete() { return true; }
+    // propagation after the letter just put in the current cell left
+    // the open cell c without letters
+    virtual void wipeout(Walker & /*w*/, int /*c*/) {}
+    // true if the letter just put in the current cell brings back a
+    // dead end met before; the compiler then tries the next letter
+    virtual bool prune(Walker & /*w*/) { return false; }
+    // the walk starts over; with keeplearned, keep what was learned
+    // that holds whatever the walk
+    virtual void rewind(bool /*keeplearned*/) {}
 };
 
 class NaiveBacktracker : public Backtracker {
@@ -115,18 +207,104 @@ public:
     bool stopHere(int /*p*/) override { return true; }
 };
 
+/**
+ * Conflict-directed backjumping. Every step has a conflict set, a
+ * bitset of the earlier steps that took letters from it; at a dead end
+ * these are the steps that filled the cells of its words, and those
+ * behind every letter that propagation rejected. A cell propagation
+ * filled stands for the cells that made it so. The walker jumps
+ * straight back to the latest of them, which inherits the rest of the
+ * set, so a later dead end there jumps on past all the steps that did
+ * not cause either. Nothing it jumps past had a fill below it.
+ */
+
+class ConflictBacktracker : public Backtracker {
+    std::vector<uint64_t> conflicts; // nwords per step
+    int nwords;
+    int target;
+    NogoodStore *nogoods;
+    std::vector<long> firstnode; // by step, -1 until a letter is tried
+    long nodes;
+    std::vector<int> found;
+    void init();
+    uint64_t *row(int step) { return &conflicts[size_t(step) * nwords]; }
+    std::vector<int> cells;
+    void addcells(Walker &w, int c, uint64_t *conf, int below);
+    void learn(Walker &w, uint64_t *conf, int culprit, long cost);
+public:
+    ConflictBacktracker(Grid &thegrid);
+    void backtrack(Walker &w) override;
+    bool stopHere(int p) override { return p == target; }
+    bool prune(Walker &w) override;
+    void wipeout(Walker &w, int c) override;
+    void rewind(bool keeplearned) override;
+    /**
+     * Conflict sets inherited at a dead end are learned as nogoods in
+     * store: no fill has those cells read as they do. A letter that
+     * completes a nogood again is pruned.
+     * The conflict sets leave out what Compiler::propagation rules
+     * out, so the two do not mix.
+     */
+    void setnogoods(NogoodStore *store) { nogoods = store; }
+};
+
 class SmartBacktracker : public Backtracker {
     // first = pos, second = bt point.
     // nb: pair<> is sorted on the first element (according to STL doc).
     typedef std::pair<int, int> cpair;
     std::list<cpair> bt_points;
+    std::vector<int> cells;
 public:
     SmartBacktracker(Grid &thegrid) : Backtracker(thegrid) {}
     void backtrack(Walker &w) override;
     bool stopHere(int p) override;
+    // the points of a dead end are dropped by the next dead end as
+    // deep, though they may still be needed further up
+    bool complete() override { return false; }
+    void wipeout(Walker &w, int c) override;
+    void rewind(bool /*keeplearned*/) override { bt_points.clear(); }
+};
+
+/**
+ * Takes the branches a Compiler hands off instead of searching them
+ * itself. A branch is the symbols of the cells filled before it, in the
+ * walker's order, followed by the symbol it tries; Compiler::compile()
+ * with the prefix searches it.
+ */
+
+class Splitter {
+public:
+    virtual ~Splitter() {}
+    virtual void split(const std::vector<Symbol> &prefix) = 0;
+};
+
+/**
+ * Told how a Compiler is getting on, every interval milliseconds or a
+ * little more, by compile() with a deadline. It is called on the
+ * compiler's thread, between letters.
+ */
+
+class Progress {
+public:
+    long interval;
+    Progress(long msecs = 100) : interval(msecs) {}
+    virtual ~Progress() {}
+    // letters tried and dead ends met so far, and the cells filled now
+    virtual void progress(long nodes, long backtracks, int depth) = 0;
 };
 
 class Compiler {
+public:
+    enum Status { filled, exhausted, suspended };
+    typedef std::chrono::steady_clock Clock;
+    // unsat is proof there is no fill; incomplete, that a search which
+    // may skip fills (see complete()) found none
+    enum Outcome { solved, timeout, cancelled, unsat, incomplete };
+    struct Result {
+        Outcome outcome;
+        long nodes;
+        long backtracks;
+    };
 protected:
     int numcells;
     int numalpha;
@@ -135,13 +313,83 @@ protected:
     Walker &w;
     Backtracker &bt;
     Dict &d;
-    bool compile_rest(double rejected = 0);
+    Random rng;
+    std::atomic<bool> *cancel;
+    Splitter *splitter;
+    int splitdepth;
+    // the step of the first cell this compiler may change
+    int floor;
+    long solutions;
+    long nodes;
+    long backtracks;
+    // cells filled by propagate(), newest last
+    std::vector<int> trail;
+    std::deque<WordBlock *> queue;
+    void queuewords(int c);
+    bool propagate(int c);
+    void unforce(unsigned mark);
+    void split(SymbolSet ss);
+
+    struct Frame {
+        int cell;
+        SymbolSet ss;   // letters left to try
+        SymbolSet bit;  // letter being tried
+        unsigned mark;  // trail length before it
+        double rejected;
+    };
+    std::vector<Frame> stack;
+    // what resume() does next; finished states are a Status
+    enum Step { entering = suspended + 1, trying, returning, finished = filled };
+    int step;
+    void enter();
+    void tryletter();
+    void catchfailure();
 public:
     Compiler(Grid &thegrid, Walker &thewalker, Backtracker &thebacktracker, Dict &thedict);
     bool compile();
+    // search only below the branch prefix, see Splitter
+    bool compile(const std::vector<Symbol> &prefix);
+    /**
+     * compile() that gives up at deadline, or once *cancelflag becomes
+     * true, and tells progress how it is going. Unless solved, the
+     * grid is left empty. Clock::time_point::max() never comes.
+     */
+    Result compile(Clock::time_point deadline, std::atomic<bool> *cancelflag = 0,
+                   Progress *progress = 0);
+    // compile() in slices: start(), then resume() until it is no longer
+    // suspended. A slice ends before a letter once budget letters have
+    // been tried; the grid then holds the partial fill. A negative
+    // budget runs to the end.
+    void start(const std::vector<Symbol> &prefix = std::vector<Symbol>());
+    Status resume(long budget = -1);
+    // give up a suspended run and empty the grid, so that start() can
+    // begin again; the cells may keep their letters as preferred, and
+    // the backtracker what it learned
+    void rewind(bool keeppreferred = false, bool keeplearned = false);
 
     bool verbose, findall, showsteps;
+    // after each letter, fill the cells left with one possible letter
+    // and give it up if a cell is left with none
+    bool propagation;
     double getRejected() { return rejected; }
+    // letters tried, and dead ends backed out of
+    long getnodes() { return nodes; }
+    long getbacktracks() { return backtracks; }
+    // cells filled now
+    int getdepth() { return w.stepCount(); }
+    // the choices of a run depend only on the seed
+    void setseed(uint64_t seed) { rng.setseed(seed); }
+    uint64_t getseed() { return rng.getseed(); }
+    // compile() gives up, returning false, once *flag becomes true
+    void setcancel(std::atomic<bool> *flag) { cancel = flag; }
+    std::atomic<bool> *getcancel() { return cancel; }
+    bool stopping() { return cancel && cancel->load(std::memory_order_relaxed); }
+    // whether a search that runs out proves there is no fill
+    bool complete() { return findall || bt.complete(); }
+    // hand the other branches of the first depth steps to s
+    void setsplitter(Splitter *s, int depth) { splitter = s; splitdepth = depth; }
+    // with findall, the fills found; compile() then leaves the grid empty
+    long getsolutions() { return solutions; }
 };
 
 void dodictbench();
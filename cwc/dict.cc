@@ -26,102 +26,216 @@
 #include <stdint.h>
 
 #include <string.h>
+#include <algorithm>
 
 #include "symbol.hh"
 #include "dict.hh"
 
 //////////////////////////////////////////////////////////////////////
-// class symbollink
+// class flattrie
 
-int SymbolLink::instancecount = 0;
-
-SymbolLink::SymbolLink() : symb(Symbol::outside), target(0), next(0) {
-    instancecount++;
+FlatTrie::FlatTrie() : len(0), nwords(0), root(0), built(true) {
 }
 
-SymbolLink *SymbolLink::addlink(Symbol s) {
-    SymbolLink *sl = new SymbolLink();
-    sl->symb = s;
-    sl->next = target;
-    target = sl;
-    return target;
+void FlatTrie::addword(Symbol *str) {
+    if (built && nwords > 0) {
+        // bring back the words of the current trie, to rebuild it
+        uint8_t word[MAXWORDLEN];
+        unpack(root, word, 0);
+    }
+    built = false;
+    for (int i = 0; i < len; i++)
+        pending.push_back(str[i].symbvalue());
 }
 
-void SymbolLink::addword(Symbol *str, int n) {
-    if (n == 0) return;
-    if (!isalpha(str[0]))
-        throw error("!!!");
-    SymbolLink *sl = getlink(str[0]);
-    if (sl == 0)
-        sl = addlink(str[0]);
-    sl->addword(str+1, n-1);
+void FlatTrie::unpack(uint32_t node, uint8_t *word, int depth) {
+    if (depth == len) {
+        pending.insert(pending.end(), word, word + len);
+        return;
+    }
+    uint32_t e = first[node];
+    for (uint32_t bits = masks[node]; bits; bits &= bits - 1, e++) {
+        word[depth] = __builtin_ctz(bits);
+        unpack(edges[e], word, depth + 1);
+    }
 }
 
-SymbolLink *SymbolLink::getlink(Symbol s) {
-    for (SymbolLink *sl = target; sl != 0; sl = sl->next) {
-        if (sl->symb == s) return sl;
+uint32_t FlatTrie::buildnode(std::vector<const uint8_t *> &words, int lo, int hi,
+                             int depth, NodeMap &nodes) {
+    if (depth == len)
+        return 0;
+
+    uint32_t key[33];
+    uint32_t &mask = key[0];
+    uint32_t *children = key + 1;
+    int nchildren = 0;
+    mask = 0;
+    for (int i = lo; i < hi; ) {
+        int symb = words[i][depth];
+        int j = i;
+        while (j < hi && words[j][depth] == symb)
+            j++;
+        mask |= 1u << symb;
+        children[nchildren++] = buildnode(words, i, j, depth + 1, nodes);
+        i = j;
     }
-    return 0;
+
+    // share the node if an identical one exists
+    std::string k((const char *)key, (nchildren + 1) * sizeof(uint32_t));
+    NodeMap::iterator i = nodes.find(k);
+    if (i != nodes.end())
+        return i->second;
+    uint32_t id = masks.size();
+    masks.push_back(mask);
+    first.push_back(edges.size());
+    edges.insert(edges.end(), children, children + nchildren);
+    nodes[k] = id;
+    return id;
 }
 
-bool SymbolLink::findpossible(Symbol *s, int len,
-                              int pos, SymbolSet &ss) {
-    if ((target == 0)&&(len==0)) {
-        if (pos == 0)
-            ss |= symb.getsymbolset();
-        return true;
-    }
-    if ((target==0)||(len==0))
-        return false;
+void FlatTrie::build() {
+    if (built)
+        return;
+    std::vector<const uint8_t *> words;
+    for (size_t i = 0; i + len <= pending.size() && len > 0; i += len)
+        words.push_back(&pending[i]);
+    int n = len;
+    std::sort(words.begin(), words.end(), [n](const uint8_t *a, const uint8_t *b) {
+        return memcmp(a, b, n) < 0;
+    });
+    words.erase(std::unique(words.begin(), words.end(), [n](const uint8_t *a, const uint8_t *b) {
+        return memcmp(a, b, n) == 0;
+    }), words.end());
 
-    if (s[0] == Symbol::empty) {
-        // search each subtree and OR the result.
-        bool atallany = false;
-        for (SymbolLink *sl = target; sl != 0; sl = sl->next) {
-            bool any = sl->findpossible(s+1, len-1, pos-1, ss);
-            if (any) {
-                atallany = true;
-                if (pos==0)
-                    ss |= sl->symb.getsymbolset();
-            }
+    masks.assign(1, 0); // node 0: end of word
+    first.assign(1, 0);
+    edges.clear();
+    NodeMap nodes;
+    nwords = words.size();
+    root = nwords ? buildnode(words, 0, nwords, 0, nodes) : 0;
+    masks.shrink_to_fit();
+    first.shrink_to_fit();
+    edges.shrink_to_fit();
+
+    std::vector<uint8_t>().swap(pending);
+    built = true;
+}
+
+// For nodes above or at pos, returns the symbols at pos that can be
+// reached from the node. Below pos, returns ~0 if the node has any
+// completion matching s and 0 otherwise. A node is always at the same
+// depth, so the answer only depends on the node, and is memoized.
+SymbolSet FlatTrie::search(uint32_t node, Symbol *s, int depth, int pos, Memo *memo) {
+    if (depth == len)
+        return ~SymbolSet(0);
+    Memo &m = memo[node & 255];
+    if (m.node == node)
+        return m.val;
+
+    uint32_t mask = masks[node];
+    SymbolSet r = 0;
+    if (s[depth] != Symbol::empty) {
+        int symb = s[depth].symbvalue();
+        if (mask & (1u << symb)) {
+            SymbolSet c = search(child(node, symb), s, depth + 1, pos, memo);
+            if (depth == pos)
+                r = c ? SymbolSet(1) << symb : 0;
+            else
+                r = c;
         }
-        return atallany;
     } else {
-        // search specific subtree
-        SymbolLink *sl = getlink(s[0]);
-        if (sl == 0)
-            return false;
-        else {
-            if (sl->findpossible(s+1, len-1, pos-1, ss)) {
-                if (pos == 0)
-                    ss |= sl->symb.getsymbolset();
-                return true;
+        uint32_t e = first[node];
+        for (uint32_t bits = mask; bits; bits &= bits - 1, e++) {
+            SymbolSet c = search(edges[e], s, depth + 1, pos, memo);
+            if (depth == pos) {
+                if (c)
+                    r |= SymbolSet(1) << __builtin_ctz(bits);
+            } else {
+                r |= c;
+                if (r && depth > pos)
+                    break; // one completion is enough
             }
-            return false;
         }
     }
+    m.node = node;
+    m.val = r;
+    return r;
 }
 
-void SymbolLink::dump(char *prefix, int len) {
-    if (target == 0) {
-        std::cout << prefix << symb << std::endl;
-        return;
-    }
+bool FlatTrie::findpossible(Symbol *s, int pos, SymbolSet &ss) {
+    if (!built)
+        build();
+    if (nwords == 0)
+        return false;
+    Memo memo[256];
+    for (int i = 0; i < 256; i++)
+        memo[i].node = ~0u;
+    SymbolSet r = search(root, s, 0, pos, memo);
+    ss |= r;
+    return r != 0;
+}
 
-    if (prefix == 0) {
-        prefix = new char[256];
-        prefix[0] = '\0';
-        for (SymbolLink *sl = target; sl; sl = sl->next) {
-            sl->dump(prefix, len);
-        }
-        delete[] prefix;
-    } else {
-        prefix[len++] = symb; prefix[len] = '\0';
-        for (SymbolLink *sl = target; sl; sl = sl->next) {
-            sl->dump(prefix, len);
+// Returns the number of completions of the node matching s, and adds
+// the symbols on their paths to sets.
+int FlatTrie::countslot(uint32_t node, Symbol *s, int depth, SymbolSet *sets) {
+    if (depth == len)
+        return 1;
+    uint32_t mask = masks[node];
+    if (s[depth] != Symbol::empty) {
+        int symb = s[depth].symbvalue();
+        if (!(mask & (1u << symb)))
+            return 0;
+        return countslot(child(node, symb), s, depth + 1, sets);
+    }
+    int n = 0;
+    uint32_t e = first[node];
+    for (uint32_t bits = mask; bits; bits &= bits - 1, e++) {
+        int c = countslot(edges[e], s, depth + 1, sets);
+        if (c) {
+            sets[depth] |= SymbolSet(1) << __builtin_ctz(bits);
+            n += c;
         }
-        prefix[--len] = '\0';
     }
+    return n;
+}
+
+int FlatTrie::findslot(Symbol *s, SymbolSet *sets) {
+    if (!built)
+        build();
+    for (int i = 0; i < len; i++)
+        sets[i] = 0;
+    int n = nwords ? countslot(root, s, 0, sets) : 0;
+    for (int i = 0; i < len; i++)
+        if (s[i] != Symbol::empty && n)
+            sets[i] = s[i].getsymbolset();
+    return n;
+}
+
+size_t FlatTrie::memoryusage() {
+    return (masks.capacity() + first.capacity() + edges.capacity()) * sizeof(uint32_t)
+        + pending.capacity();
+}
+
+void FlatTrie::dump(uint32_t node, char *prefix, int depth, const Alphabet &a) {
+    if (depth == len) {
+        prefix[depth] = '\0';
+        std::cout << prefix << std::endl;
+        return;
+    }
+    uint32_t e = first[node];
+    for (uint32_t bits = masks[node]; bits; bits &= bits - 1, e++) {
+        prefix[depth] = a.letter(Symbol::symbolbit(bits & -bits));
+        dump(edges[e], prefix, depth + 1, a);
+    }
+}
+
+void FlatTrie::dump(const Alphabet &a) {
+    if (!built)
+        build();
+    if (nwords == 0)
+        return;
+    char prefix[MAXWORDLEN + 1];
+    dump(root, prefix, 0, a);
 }
 //////////////////////////////////////////////////////////////////////
 // dict
@@ -132,24 +246,63 @@ Dict::Dict() {
 Dict::~Dict() {
 }
 
+int Dict::findslot(Symbol *s, int len, SymbolSet *sets) {
+    bool any = true;
+    int nempty = 0;
+    for (int i = 0; i < len && any; i++) {
+        if (s[i] == Symbol::empty) {
+            sets[i] = findpossible(s, len, i);
+            any = sets[i] != 0;
+            nempty++;
+        }
+    }
+    if (any && nempty == 0)
+        any = findpossible(s, len, 0) != 0;
+    for (int i = 0; i < len; i++) {
+        if (!any)
+            sets[i] = 0;
+        else if (s[i] != Symbol::empty)
+            sets[i] = s[i].getsymbolset();
+    }
+    return any ? -1 : 0;
+}
+
+size_t Dict::memoryusage() {
+    return 0;
+}
+
 //////////////////////////////////////////////////////////////////////
 // btree_dict
 
-BtreeDict::BtreeDict() : primary() {
+BtreeDict::BtreeDict(const Alphabet &a) : alpha(a) {
+    for (int n = 0; n < MAXWORDLEN; n++)
+        primary[n].setlength(n);
 }
 
 void BtreeDict::addWord(Symbol *str, int n) {
-    primary[n].addword(str, n);
+    if (n >= MAXWORDLEN)
+        return;
+    primary[n].addword(str);
 }
 
 int BtreeDict::size() {
-    return SymbolLink::instancecount;
+    int n = 0;
+    for (int len = 0; len < MAXWORDLEN; len++)
+        n += primary[len].numnodes();
+    return n;
+}
+
+size_t BtreeDict::memoryusage() {
+    size_t n = 0;
+    for (int len = 0; len < MAXWORDLEN; len++)
+        n += primary[len].memoryusage();
+    return n;
 }
 
 void BtreeDict::load(const std::string &fn) {
     std::cout << "Loading wordlist and building dictionary... " << std::flush;
-    bool chset[256];
-    for (int i=0;i<256;i++) chset[i] = false;
+    bool chset[32];
+    for (int i=0;i<32;i++) chset[i] = false;
 
     std::ifstream f(fn.c_str());
     if (!f.is_open()) throw error("Failed to open dictionary file");
@@ -164,15 +317,15 @@ void BtreeDict::load(const std::string &fn) {
         bool ok = true;
         for (int i=0;i<wlen;i++) {
             sz[i] = tolower(sz[i]);
-            if (!isalpha(sz[i])) {
+            if (!alpha.isletter(sz[i])) {
                 ok = false;
             }
         }
         if (ok) {
             Symbol *symbs = new Symbol[wlen];
             for (int i=0;i<wlen;i++) {
-                symbs[i] = sz[i];
-                chset[uint8_t(sz[i])] = true;
+                symbs[i] = alpha.symbol(sz[i]);
+                chset[symbs[i].symbvalue()] = true;
             }
             addWord(symbs, wlen);
             wordsused++;
@@ -182,23 +335,33 @@ void BtreeDict::load(const std::string &fn) {
         }
 
     }
-    for (int i=0;i<256;i++) {
+    for (int i=0;i<32;i++) {
         if (chset[i]) {
             Symbol s[1];
-            s[0] = i;
+            s[0] = Symbol::symbolbit(SymbolSet(1) << i);
             addWord(s, 1);
         }
     }
+    for (int len = 0; len < MAXWORDLEN; len++)
+        primary[len].build();
     std::cout << "ok" << std::endl;
     std::cout << wordsused << " of " << wordcount << " words used." << std::endl;
+    std::cout << size() << " trie nodes, " << memoryusage() << " bytes." << std::endl;
 }
 
 SymbolSet BtreeDict::findpossible(Symbol *s, int len, int pos) {
     SymbolSet ss = 0;
-    primary[len].findpossible(s, len, pos, ss);
+    if (len < MAXWORDLEN)
+        primary[len].findpossible(s, pos, ss);
     return ss;
 }
 
+int BtreeDict::findslot(Symbol *s, int len, SymbolSet *sets) {
+    if (len >= MAXWORDLEN)
+        return Dict::findslot(s, len, sets);
+    return primary[len].findslot(s, sets);
+}
+
 void BtreeDict::dump(int len) {
-    primary[len].dump();
+    primary[len].dump(alpha);
 }
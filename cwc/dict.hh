@@ -22,20 +22,54 @@
 #ifndef CWC_DICT_HH
 #define CWC_DICT_HH
 
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <stddef.h>
+#include <stdint.h>
 #include "symbol.hh"
 
 //////////////////////////////////////////////////////////////////////
 
-struct SymbolLink {
-    Symbol symb;
-    static int instancecount;
-    SymbolLink *target, *next;
-    SymbolLink *getlink(Symbol);
-    SymbolLink();
-    SymbolLink *addlink(Symbol);
-    void addword(Symbol *, int);
-    bool findpossible(Symbol *s, int len, int pos, SymbolSet &ss);
-    void dump(char *prefix = 0, int len = 0);
+/**
+ * Minimized trie (DAWG) of the words of one length, kept in flat
+ * arrays. A node has a mask of the symbols it has children for, and
+ * its children are stored consecutively in symbol order, so the child
+ * for a symbol is found by counting the mask bits below it. Identical
+ * subtrees are shared. Node 0 is the end of a word.
+ *
+ * Words are collected by addword() and the trie is (re)built on the
+ * next query.
+ */
+class FlatTrie {
+    typedef std::unordered_map<std::string, uint32_t> NodeMap;
+    struct Memo { uint32_t node; SymbolSet val; };
+    int len, nwords;
+    uint32_t root;
+    std::vector<uint32_t> masks, first, edges;
+    std::vector<uint8_t> pending; // len symbol values per word
+    bool built;
+
+    uint32_t child(uint32_t node, int symb) {
+        uint32_t mask = masks[node];
+        return edges[first[node] + __builtin_popcount(mask & ((1u << symb) - 1))];
+    }
+    uint32_t buildnode(std::vector<const uint8_t *> &words, int lo, int hi,
+                       int depth, NodeMap &nodes);
+    void unpack(uint32_t node, uint8_t *word, int depth);
+    void dump(uint32_t node, char *prefix, int depth, const Alphabet &a);
+    SymbolSet search(uint32_t node, Symbol *s, int depth, int pos, Memo *memo);
+    int countslot(uint32_t node, Symbol *s, int depth, SymbolSet *sets);
+public:
+    FlatTrie();
+    void setlength(int n) { len = n; }
+    void addword(Symbol *);
+    void build();
+    bool findpossible(Symbol *s, int pos, SymbolSet &ss);
+    int findslot(Symbol *s, SymbolSet *sets);
+    int numnodes() { return masks.size(); }
+    size_t memoryusage();
+    void dump(const Alphabet &a);
 };
 
 class Dict {
@@ -45,16 +79,32 @@ public:
 
     virtual void load(const std::string &fn) = 0;
     virtual SymbolSet findpossible(Symbol *s, int len, int pos) = 0;
+    /**
+     * Answers findpossible() for every position of the pattern at once:
+     * sets[i] gets the symbols possible at position i (for a fixed
+     * position, its own symbol if the pattern has any match). Returns
+     * the number of matching words, or -1 if the dictionary cannot
+     * count them. The default asks findpossible() once per position.
+     */
+    virtual int findslot(Symbol *s, int len, SymbolSet *sets);
+    /**
+     * bytes held by the index itself, not counting the word list.
+     * 0 if the dictionary does not know.
+     */
+    virtual size_t memoryusage();
 };
 
 class BtreeDict : public Dict {
-    SymbolLink primary[MAXWORDLEN];
+    FlatTrie primary[MAXWORDLEN];
+    const Alphabet &alpha;
 public:
-    BtreeDict();
+    BtreeDict(const Alphabet &a = Alphabet::latin());
     void addWord(Symbol *, int);
     void load(const std::string &fn);
     int size();
+    size_t memoryusage();
     SymbolSet findpossible(Symbol *s, int len, int pos);
+    int findslot(Symbol *s, int len, SymbolSet *sets);
     void dump(int len);
 };
 
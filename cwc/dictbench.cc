@@ -0,0 +1,381 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+
+/**
+ * Dictionary benchmark. Solves the bundled patterns once with a
+ * LetterDict, recording every query the compiler asks the dictionary,
+ * and replays the recorded queries against each engine. For each
+ * engine it reports build time, index memory, queries per second and
+ * latency percentiles, and counts answers that differ from the ones
+ * recorded, so a new word list or engine can be checked before it
+ * ships.
+ *
+ * Build and run from this directory:
+ *   g++ -O2 -o dictbench dictbench.cc cwc.cc grid.cc domain.cc dict.cc \
+ *       letterdict.cc bitdict.cc mappeddict.cc cacheddict.cc scandict.cc \
+ *       selectdict.cc postings.cc wordlist.cc symbol.cc random.cc timer.cc \
+ *       nogood.cc
+ *   ./dictbench -d /usr/share/dict/words -g ../patterns
+ **/
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "cwc.hh"
+#include "letterdict.hh"
+#include "bitdict.hh"
+#include "mappeddict.hh"
+#include "cacheddict.hh"
+#include "scandict.hh"
+#include "selectdict.hh"
+
+typedef std::chrono::steady_clock Clock;
+
+//////////////////////////////////////////////////////////////////////
+// query log
+
+namespace {
+
+// one recorded query; pos is -1 for findslot()
+struct Query {
+    int len, pos;
+    Symbol s[MAXWORDLEN];
+    SymbolSet answer;
+};
+
+std::vector<Query> queries;
+long maxqueries = 50000; // per pattern
+
+// findslot() answers compared as one value, the count is left out
+// since not every engine can give it
+SymbolSet slothash(SymbolSet *sets, int len) {
+    SymbolSet h = 0;
+    for (int i = 0; i < len; i++)
+        h = (h << 7 | h >> (8 * sizeof(SymbolSet) - 7)) ^ sets[i];
+    return h;
+}
+
+class RecordingDict : public Dict {
+    Dict &d;
+    long n;
+public:
+    RecordingDict(Dict &thedict) : d(thedict), n(0) {}
+    void load(const std::string &fn) { d.load(fn); }
+    void restart() { n = 0; }
+    SymbolSet findpossible(Symbol *s, int len, int pos) {
+        Query q = record(s, len, pos);
+        q.answer = d.findpossible(s, len, pos);
+        queries.push_back(q);
+        return q.answer;
+    }
+    int findslot(Symbol *s, int len, SymbolSet *sets) {
+        Query q = record(s, len, -1);
+        int r = d.findslot(s, len, sets);
+        q.answer = slothash(sets, len);
+        queries.push_back(q);
+        return r;
+    }
+private:
+    Query record(Symbol *s, int len, int pos) {
+        if (++n > maxqueries) throw error("query limit");
+        Query q;
+        q.len = len;
+        q.pos = pos;
+        for (int i = 0; i < len; i++) q.s[i] = s[i];
+        return q;
+    }
+};
+
+// cached engine owning the dictionary it caches
+class OwningCache : public CachedDict {
+    Dict *inner;
+public:
+    OwningCache(Dict *d) : CachedDict(*d), inner(d) {}
+    ~OwningCache() { delete inner; }
+    size_t memoryusage() { return CachedDict::memoryusage() + inner->memoryusage(); }
+};
+
+// selecting engine owning the engines it selects from, all built on
+// one word list
+class OwningSelect : public SelectDict {
+    WordList wl;
+    LetterDict letter;
+    BitDict bit;
+    ScanDict scan;
+public:
+    OwningSelect() {
+        wl.load(setup.dictfile);
+        letter.wl = bit.wl = scan.wl = &wl;
+        int nwords = wl.numwords();
+        for (int i = 0; i < nwords; i++) {
+            letter.addword(wl[i], i);
+            bit.addword(wl[i], i);
+            scan.addword(wl[i], i);
+        }
+        letter.compact();
+        bit.build();
+        addengine(letter, "letter");
+        addengine(bit, "bit");
+        addengine(scan, "scan");
+        calibrate(wl);
+    }
+};
+
+// discards std::cout while alive; the compiler and the loaders talk
+class Quiet {
+    std::streambuf *old;
+public:
+    Quiet() : old(std::cout.rdbuf(0)) {}
+    ~Quiet() { std::cout.rdbuf(old); std::cout.clear(); }
+};
+
+std::vector<std::string> patternfiles(const std::string &path) {
+    std::vector<std::string> files;
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) throw error("No such pattern: " + path);
+    if (!S_ISDIR(st.st_mode)) {
+        files.push_back(path);
+        return files;
+    }
+    DIR *dir = opendir(path.c_str());
+    if (!dir) throw error("Failed to open " + path);
+    while (struct dirent *e = readdir(dir)) {
+        if (e->d_name[0] != '.')
+            files.push_back(path + "/" + e->d_name);
+    }
+    closedir(dir);
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+void record(LetterDict &ref) {
+    RecordingDict rec(ref);
+    std::vector<std::string> files = patternfiles(setup.gridfile);
+    int nused = 0;
+    for (size_t i = 0; i < files.size(); i++) {
+        Grid g;
+        std::ifstream f(files[i].c_str());
+        try {
+            Quiet q;
+            g.load_template(f);
+        } catch (error) {
+            continue; // not a square template
+        }
+        if (g.numopen() == 0) continue;
+        size_t before = queries.size();
+        rec.restart();
+        FloodWalker w(g);
+        SmartBacktracker bt(g);
+        Compiler c(g, w, bt, rec);
+        c.setseed(setup.seed);
+        try {
+            Quiet q;
+            c.compile();
+        } catch (error) {
+            // query limit reached, keep what was recorded
+        }
+        nused++;
+        if (setup.verbose)
+            std::cout << files[i] << ": " << queries.size() - before << " queries" << std::endl;
+    }
+    std::cout << "Recorded " << queries.size() << " queries from "
+              << nused << " patterns" << std::endl;
+}
+
+struct Engine {
+    const char *name;
+    Dict *(*make)();
+};
+
+std::string mappedfile;
+
+Dict *makeletter() { LetterDict *d = new LetterDict; d->load(setup.dictfile); return d; }
+Dict *makebtree() { BtreeDict *d = new BtreeDict; d->load(setup.dictfile); return d; }
+Dict *makebit() { BitDict *d = new BitDict; d->load(setup.dictfile); return d; }
+Dict *makemapped() { MappedDict *d = new MappedDict; d->load(mappedfile); return d; }
+Dict *makescan() { ScanDict *d = new ScanDict; d->load(setup.dictfile); return d; }
+Dict *makecached() { return new OwningCache(makeletter()); }
+Dict *makeselect() { return new OwningSelect; }
+
+// new engines go here
+Engine engines[] = {
+    { "letter", makeletter },
+    { "btree", makebtree },
+    { "bit", makebit },
+    { "mapped", makemapped },
+    { "scan", makescan },
+    { "cached", makecached },
+    { "select", makeselect },
+};
+
+double percentile(std::vector<double> &v, double p) {
+    if (v.empty()) return 0;
+    size_t i = size_t(p * (v.size() - 1) + 0.5);
+    return v[i];
+}
+
+double elapsed(Clock::time_point t0, Clock::time_point t1) {
+    return std::chrono::duration<double, std::micro>(t1 - t0).count();
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////
+// dictbench
+
+/**
+ * replays the recorded queries against d and prints its memory use,
+ * queries per second and latency percentiles. The throughput pass runs
+ * the log untimed; latencies come from a second pass timing every
+ * query. Memory is taken after the first pass, so tables an engine
+ * builds as it is queried are counted.
+ * Returns the number of answers differing from the recorded ones.
+ */
+int dictbench(Dict &d) {
+    int nq = queries.size();
+    SymbolSet sets[MAXWORDLEN];
+    int wrong = 0;
+
+    Clock::time_point t0 = Clock::now();
+    for (int i = 0; i < nq; i++) {
+        Query &q = queries[i];
+        SymbolSet a;
+        if (q.pos < 0) {
+            d.findslot(q.s, q.len, sets);
+            a = slothash(sets, q.len);
+        } else
+            a = d.findpossible(q.s, q.len, q.pos);
+        if (a != q.answer) wrong++;
+    }
+    double total = elapsed(t0, Clock::now());
+    std::cout << std::setw(11) << d.memoryusage() / 1024 << std::flush;
+
+    std::vector<double> lat(nq);
+    for (int i = 0; i < nq; i++) {
+        Query &q = queries[i];
+        Clock::time_point t1 = Clock::now();
+        if (q.pos < 0)
+            d.findslot(q.s, q.len, sets);
+        else
+            d.findpossible(q.s, q.len, q.pos);
+        lat[i] = elapsed(t1, Clock::now());
+    }
+    std::sort(lat.begin(), lat.end());
+
+    std::cout << std::setw(12) << (total > 0 ? long(nq / total * 1e6) : 0)
+              << std::setw(9) << percentile(lat, 0.5)
+              << std::setw(9) << percentile(lat, 0.9)
+              << std::setw(9) << percentile(lat, 0.99)
+              << std::setw(9) << (lat.empty() ? 0 : lat.back())
+              << std::setw(7) << wrong << std::endl;
+    return wrong;
+}
+
+/**
+ * records the queries of solving setup.gridfile (a template or a
+ * directory of them) with setup.dictfile, then benchmarks every
+ * engine on them.
+ */
+void dodictbench() {
+    LetterDict ref;
+    {
+        Quiet q;
+        ref.load(setup.dictfile);
+    }
+    record(ref);
+    if (queries.empty()) throw error("No queries recorded");
+
+    char tmpl[] = "/tmp/dictbenchXXXXXX";
+    int fd = mkstemp(tmpl);
+    if (fd < 0) throw error("Failed to create temporary file");
+    close(fd);
+    mappedfile = tmpl;
+    MappedDict::write(mappedfile, *ref.wl, ref);
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << std::left << std::setw(8) << "engine" << std::right
+              << std::setw(10) << "build ms" << std::setw(11) << "memory KB"
+              << std::setw(12) << "queries/s" << std::setw(9) << "p50 us"
+              << std::setw(9) << "p90 us" << std::setw(9) << "p99 us"
+              << std::setw(9) << "max us" << std::setw(7) << "wrong" << std::endl;
+
+    int wrong = 0;
+    for (size_t i = 0; i < sizeof(engines) / sizeof(engines[0]); i++) {
+        Clock::time_point t0 = Clock::now();
+        Dict *d;
+        {
+            Quiet q;
+            d = engines[i].make();
+        }
+        double build = elapsed(t0, Clock::now()) / 1000;
+        std::cout << std::left << std::setw(8) << engines[i].name << std::right
+                  << std::setw(10) << build << std::flush;
+        wrong += dictbench(*d);
+        delete d;
+    }
+    unlink(mappedfile.c_str());
+    if (wrong)
+        std::cout << wrong << " answers differ from the reference" << std::endl;
+}
+
+//////////////////////////////////////////////////////////////////////
+// main
+
+int main(int argc, char *argv[]) {
+    setup.gridfile = "../patterns";
+    setup.seed = 1;
+    setup.benchdict = true;
+    int opt;
+    while ((opt = getopt(argc, argv, "d:g:n:s:v")) != -1) {
+        switch (opt) {
+        case 'd': setup.dictfile = optarg; break;
+        case 'g': setup.gridfile = optarg; break;
+        case 'n': maxqueries = atol(optarg); break;
+        case 's': setup.setseed = true; setup.seed = atoi(optarg); break;
+        case 'v': setup.verbose = true; break;
+        default:
+            std::cout << "Usage: " << argv[0]
+                      << " [-d wordlist] [-g pattern or directory] [-n max queries per pattern]"
+                      << " [-s seed] [-v]" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    try {
+        dodictbench();
+    } catch (error e) {
+        std::cout << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
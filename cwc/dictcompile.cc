@@ -0,0 +1,120 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+
+/**
+ * Offline compiler for the MappedDict file format. Reads a word list,
+ * either one word per line or tab separated lines with the hint first
+ * and the word last (like the hint files), and writes the words and
+ * their letter indexes to a file the game can map at startup. Lines
+ * are read as Crossword::parseWordlist() reads them, so the file holds
+ * exactly the words the game has hints for.
+ *
+ * Build from this directory:
+ *   g++ -O2 -o dictcompile dictcompile.cc mappeddict.cc letterdict.cc \
+ *       postings.cc wordlist.cc symbol.cc random.cc dict.cc
+ *   ./dictcompile ../nyt.tsv ../nyt.cwd
+ **/
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <set>
+#include <stdlib.h>
+#include <ctype.h>
+
+#include "letterdict.hh"
+#include "mappeddict.hh"
+
+static std::string trimmed(const std::string &s) {
+    size_t b = 0, e = s.size();
+    while (b < e && isspace((unsigned char)s[b]))
+        b++;
+    while (e > b && isspace((unsigned char)s[e-1]))
+        e--;
+    return s.substr(b, e - b);
+}
+
+// the word of a line, or "" if the game would skip it
+static std::string parseline(const std::string &line) {
+    std::vector<std::string> parts;
+    size_t start = 0;
+    for (;;) {
+        size_t tab = line.find('\t', start);
+        std::string part = line.substr(start, tab == std::string::npos ? std::string::npos : tab - start);
+        if (!part.empty())
+            parts.push_back(part);
+        if (tab == std::string::npos)
+            break;
+        start = tab + 1;
+    }
+    if (parts.empty())
+        return "";
+    std::string hint = trimmed(parts.front());
+    std::string word = trimmed(parts.back());
+    if (hint.size() >= 2 && hint[0] == '"' && hint[hint.size()-1] == '"')
+        hint = hint.substr(1, hint.size() - 2);
+    if (hint.empty())
+        return "";
+    for (size_t i = 0; i < word.size(); i++)
+        word[i] = tolower(word[i]);
+    return word;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 3) {
+        std::cout << "Usage: " << argv[0] << " <wordlist> <output>" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    try {
+        std::ifstream f(argv[1]);
+        if (!f.is_open()) throw error("Failed to open file");
+
+        WordList wl;
+        std::set<std::string> seen;
+        std::string line;
+        while (std::getline(f, line)) {
+            std::string word = parseline(line);
+            // the game keeps one hint per word
+            if (!word.empty() && seen.insert(word).second)
+                wl.addWord(word);
+        }
+
+        LetterDict d;
+        d.wl = &wl;
+        int nwords = wl.numwords();
+        for (int i = 0; i < nwords; i++)
+            d.addword(wl[i], i);
+        d.report(std::cout);
+
+        MappedDict::write(argv[2], wl, d);
+
+        MappedDict check;
+        check.load(argv[2]);
+        std::cout << "Wrote " << check.numwords() << " words to " << argv[2] << std::endl;
+    } catch (error e) {
+        std::cout << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
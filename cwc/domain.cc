@@ -0,0 +1,116 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+
+#include "domain.hh"
+#include "bitdict.hh"
+
+//////////////////////////////////////////////////////////////////////
+// slotdomain
+
+SlotDomain::SlotDomain(BitDict &thedict, int length)
+    : d(thedict), len(length), masks(length * 32), nlive(0) {
+    for (int pos = 0; pos < len; pos++) {
+        all[pos] = d.allat(len, pos);
+        for (int ch = 0; ch < 32; ch++)
+            masks[pos*32 + ch] = d.letterbits(len, pos, ch);
+    }
+}
+
+// start over with the words matching pattern, forgetting the trail
+void SlotDomain::reset(Symbol *pattern) {
+    int nwords = d.numwords(len);
+    int nblocks = d.numblocks(len);
+    bits.assign(nblocks, ~uint64_t(0));
+    if (nwords % 64)
+        bits[nblocks - 1] = (uint64_t(1) << (nwords % 64)) - 1;
+    live.resize(nblocks);
+    for (int b = 0; b < nblocks; b++)
+        live[b] = b;
+    nlive = nblocks;
+
+    for (int pos = 0; pos < len; pos++)
+        if (pattern[pos] != Symbol::empty)
+            narrow(pos, pattern[pos]);
+    trail.clear();
+    marks.clear();
+}
+
+void SlotDomain::narrow(int pos, Symbol s) {
+    Mark m = { uint32_t(trail.size()), nlive, pos };
+    marks.push_back(m);
+
+    const uint64_t *mask = masks[pos*32 + s.symbvalue()];
+    for (uint32_t i = 0; i < nlive; ) {
+        uint32_t b = live[i];
+        uint64_t nb = mask ? bits[b] & mask[b] : 0;
+        if (nb != bits[b]) {
+            Undo u = { b, bits[b] };
+            trail.push_back(u);
+            bits[b] = nb;
+        }
+        if (nb == 0) {
+            // swap it behind the live part
+            live[i] = live[nlive - 1];
+            live[nlive - 1] = b;
+            nlive--;
+        } else
+            i++;
+    }
+}
+
+bool SlotDomain::undo(int pos) {
+    if (marks.empty() || marks.back().pos != pos)
+        return false;
+    Mark m = marks.back();
+    marks.pop_back();
+    while (trail.size() > m.trail) {
+        bits[trail.back().block] = trail.back().bits;
+        trail.pop_back();
+    }
+    nlive = m.nlive;
+    return true;
+}
+
+int SlotDomain::count() {
+    int n = 0;
+    for (uint32_t i = 0; i < nlive; i++)
+        n += __builtin_popcountll(bits[live[i]]);
+    return n;
+}
+
+SymbolSet SlotDomain::possible(int pos) {
+    SymbolSet ss = 0;
+    SymbolSet cand = all[pos];
+    for (int ch = 0; cand; ch++, cand >>= 1) {
+        if (!(cand & 1))
+            continue;
+        const uint64_t *mask = masks[pos*32 + ch];
+        for (uint32_t i = 0; i < nlive; i++) {
+            uint32_t b = live[i];
+            if (bits[b] & mask[b]) {
+                ss |= SymbolSet(1) << ch;
+                break;
+            }
+        }
+    }
+    return ss;
+}
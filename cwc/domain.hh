@@ -0,0 +1,74 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+
+#ifndef CWC_DOMAIN_HH
+#define CWC_DOMAIN_HH
+
+#include <vector>
+#include <stdint.h>
+#include "symbol.hh"
+
+class BitDict;
+
+/**
+ * The words of a BitDict that still fit a word block, as a bitset that
+ * is narrowed each time one of the cells gets a symbol. Changes are
+ * recorded on a trail so undo() restores the set from before the last
+ * narrow(). Only blocks that still hold words are visited: they are
+ * kept at the front of the live list, and a block that empties is
+ * swapped behind the live part, so restoring the count restores the
+ * list.
+ */
+
+class SlotDomain {
+    struct Undo {
+        uint32_t block;
+        uint64_t bits;
+    };
+    struct Mark {
+        uint32_t trail;
+        uint32_t nlive;
+        int pos;
+    };
+
+    BitDict &d;
+    int len;
+    std::vector<const uint64_t *> masks; // [pos*32 + symbol], from BitDict
+    SymbolSet all[MAXWORDLEN];
+    std::vector<uint64_t> bits;
+    std::vector<uint32_t> live;
+    uint32_t nlive;
+    std::vector<Undo> trail;
+    std::vector<Mark> marks;
+public:
+    SlotDomain(BitDict &thedict, int length);
+    BitDict *dict() { return &d; }
+    void reset(Symbol *pattern);
+    void narrow(int pos, Symbol s);
+    // undo the last narrow(), if it was for pos
+    bool undo(int pos);
+    int depth() { return marks.size(); }
+    int count();
+    SymbolSet possible(int pos);
+};
+
+#endif // CWC_DOMAIN_HH
@@ -25,20 +25,92 @@
 #include <algorithm>
 
 #include "grid.hh"
+#include "bitdict.hh"
+#include "domain.hh"
 
 //////////////////////////////////////////////////////////////////////
 // wordblock
 
-WordBlock::WordBlock() {
+WordBlock::WordBlock() : known(0), nmatches(-1), possibledict(0), domain(0) {
     cls_size = 0;
 }
 
+WordBlock::~WordBlock() {
+    delete domain;
+}
+
+void WordBlock::setdomain(SlotDomain *sd) {
+    delete domain;
+    domain = sd;
+    if (domain) {
+        Symbol word[cls_size+1]; word[cls_size] = Symbol::outside;
+        getword(word);
+        domain->reset(word);
+    }
+    invalidate();
+}
+
+static bool isletter(const Symbol &s) {
+    return !(s == Symbol::empty) && !(s == Symbol::outside);
+}
+
+void WordBlock::cellchanged(int pos, Symbol old, Symbol now) {
+    invalidate();
+    if (!domain)
+        return;
+    if (isletter(old) && !domain->undo(pos)) {
+        // not the last cell set in this block; start over
+        Symbol word[cls_size+1]; word[cls_size] = Symbol::outside;
+        getword(word);
+        domain->reset(word);
+        return;
+    }
+    if (isletter(now))
+        domain->narrow(pos, now);
+}
+
 void WordBlock::getword(Symbol *s) {
     int i, len = cls.size();
     for (i = 0; i < len; i++)
         s[i] = cls[i]->getsymbol();
 }
 
+void WordBlock::usedict(Dict &d) {
+    if (possibledict != &d) {
+        possibledict = &d;
+        possible.resize(cls_size);
+        invalidate();
+    }
+}
+
+SymbolSet WordBlock::findpossible(Dict &d, int pos) {
+    usedict(d);
+    if (!(known & (1u << pos))) {
+        if (domain && domain->dict() == &d) {
+            possible[pos] = domain->possible(pos);
+        } else {
+            Symbol word[cls_size+1]; word[cls_size] = Symbol::outside;
+            getword(word);
+            possible[pos] = d.findpossible(word, cls_size, pos);
+        }
+        known |= 1u << pos;
+    }
+    return possible[pos];
+}
+
+int WordBlock::nummatches(Dict &d) {
+    usedict(d);
+    if (nmatches < 0 && domain && domain->dict() == &d) {
+        nmatches = domain->count();
+    } else if (nmatches < 0) {
+        Symbol word[cls_size+1]; word[cls_size] = Symbol::outside;
+        getword(word);
+        nmatches = d.findslot(word, cls_size, &possible[0]);
+        known = ~0u;
+    }
+    return nmatches;
+}
+
 //////////////////////////////////////////////////////////////////////
 // class cell
 
@@ -54,16 +126,25 @@ void Cell::addword(WordBlock *w, int pos) {
     wbl_size++;
 }
 
+void Cell::changed(Symbol old) {
+    for (int i = 0; i < wbl_size; i++)
+        wbl[i].wbl->cellchanged(wbl[i].pos, old, symb);
+}
+
 void Cell::setsymbol(const Symbol &s) {
     if (locked)
         throw error("Attempt to set symbol in locked cell");
     if (!(s == Symbol::empty) && !(s == Symbol::outside))
         attempts++;
+    Symbol old = symb;
     symb = s;
+    changed(old);
 }
 
 void Cell::remove() {
+    Symbol old = symb;
     symb = Symbol::outside;
+    changed(old);
 }
 
 void Cell::clear(bool setpreferred) {
@@ -71,11 +152,9 @@ void Cell::clear(bool setpreferred) {
         preferred = symb;
     else
         preferred = Symbol::none;
+    Symbol old = symb;
     symb = Symbol::empty;
-}
-
-std::ostream &operator << (std::ostream &os, Cell &c) {
-    return os << c.symb;
+    changed(old);
 }
 
 bool Cell::isoutside() {
@@ -86,14 +165,12 @@ bool Cell::isfilled() {
     return (symb!=Symbol::empty)&&(symb!=Symbol::outside);
 }
 
-std::string Cell::tostring() {
-    std::ostringstream s;
-    s << symb;
-    return s.str();
+std::string Cell::tostring(const Alphabet &a) {
+    return std::string(1, a.letter(symb));
 }
 
-std::string Cell::touppercasestring() {
-    std::string s = tostring();
+std::string Cell::touppercasestring(const Alphabet &a) {
+    std::string s = tostring(a);
     transform(s.begin(), s.end(), s.begin(), toupper);
     return s;
 }
@@ -111,13 +188,42 @@ std::ostream &operator << (std::ostream &os, Coord &c) {
 //////////////////////////////////////////////////////////////////////
 // class grid
 
-Grid::Grid(int width, int height)
-    : cls(0), cls_size(0), verbose(false) {
+Grid::Grid(int width, int height, const Alphabet &a)
+    : cls(0), cls_size(0), alpha(&a), verbose(false) {
     init_grid(width, height);
     cellno(-1).setsymbol(Symbol::outside);
     buildwords();
 }
 
+Grid::Grid(const Grid &g)
+    : cls(g.cls), cls_size(g.cls_size), alpha(g.alpha), verbose(g.verbose),
+      w(g.w), h(g.h) {
+    for (int n = 0; n < numcells(); n++)
+        cls[n].clearwords();
+    // same blocks in the same order, so every cell lists its words as
+    // in g
+    for (unsigned i = 0; i < g.wbl.size(); i++) {
+        WordBlock *wb = new WordBlock();
+        wbl.push_back(wb);
+        int len = g.wbl[i]->length();
+        for (int p = 0; p < len; p++) {
+            int cno = g.wbl[i]->getcellno(p);
+            wb->addcell(cno, *this);
+            cls[cno].addword(wb, p);
+        }
+    }
+}
+
+Grid::~Grid() {
+    clearwordblocks();
+}
+
+void Grid::clearwordblocks() {
+    for (unsigned i = 0; i < wbl.size(); i++)
+        delete wbl[i];
+    wbl.clear();
+}
+
 void Grid::init_grid(int w, int h) {
     this->w = w;
     this->h = h;
@@ -163,20 +269,9 @@ SymbolSet Cell::findpossible(Dict &d) {
     SymbolSet ss = ~0;
 
     for (int i = 0; i < nwords; i++) {
-
-        int pos = getpos(i);
-        WordBlock &wb = getwordblock(i);
-        int len = wb.length();
-
-        Symbol word[len+1]; word[len] = Symbol::outside;
-
-        wb.getword(word);
-
-        ss &= d.findpossible(word, len, pos); // intersect solutions
-//        if (setup.verbose) {
-//            cout << "vertical: "; dumpsymbollist(word, len);
-//            dumpset(ss);
-//        }
+        // the word block asks for all its positions at once, and keeps
+        // the answer until one of its cells changes
+        ss &= getwordblock(i).findpossible(d, getpos(i)); // intersect solutions
     }
 
     return ss;
@@ -211,7 +306,9 @@ void Grid::load_template(std::istream &tf) {
             }
             else if (isalpha(ch)) {
                 std::cout << "character: "  << ch << std::endl;
-                cellat(x, y).setsymbol(tolower(ch));
+                if (!alpha->isletter(tolower(ch)))
+                    throw error("Letter not in alphabet");
+                cellat(x, y).setsymbol(alpha->symbol(tolower(ch)));
             }
             else
                 throw error("Invalid character in input file");
@@ -231,7 +328,7 @@ void Grid::load(const std::string &fn) {
 void Grid::load(std::istream &f)
 {
     cls.clear();
-    wbl.clear();
+    clearwordblocks();
     w = h = 0;
     std::string ln;
 
@@ -267,7 +364,7 @@ void Grid::load(std::istream &f)
  */
 
 void Grid::buildwords() {
-    wbl.clear();
+    clearwordblocks();
     for (int n = 0; n < numcells(); n++)
         cls[n].clearwords();
 
@@ -353,7 +450,7 @@ void Grid::dump_ascii(std::ostream &os,Answers * an) {
             if (c.isoutside())
                 os << "XXX|";
             else
-                os << ' ' <<  c << " |";
+                os << ' ' << alpha->letter(c.getsymbol()) << " |";
         }
         os << std::endl;
         os << vertbar << std::endl;
@@ -367,7 +464,7 @@ void Grid::dump(std::ostream &os, Answers * an) {
             Symbol *s = new Symbol[len + 1];
             s[len] = Symbol::outside;
             wbl[i]->getword(s);
-            os << s << ' ';
+            os << alpha->word(s) << ' ';
             delete[] s;
 
             os << '(';
@@ -400,17 +497,11 @@ Answers Grid::getanswers() {
             int secondcell=wb->getcellno(1);
             bool across = (firstcell + 1) == secondcell;
             // Get the answer as a string:
-            char * c_str=new char[l+1];
             Symbol *symbols = new Symbol[l+1];
             symbols[l] = Symbol::outside;
             wb->getword(symbols);
-            for(int k=0;k<l;++k) {
-                c_str[k] = (char)symbols[k];
-            }
-            c_str[l] = 0;
-            std::string string_version(c_str);
+            std::string string_version = alpha->word(symbols, l);
             delete [] symbols;
-            delete [] c_str;
             // Add those:
             if (across) {
                 c.across.cells.insert(firstcell);
@@ -512,6 +603,71 @@ void Grid::lock() {
             cellno(i).lock();
 }
 
+void Grid::copyfill(Grid &g) {
+    int n = numcells();
+    if (g.numcells() != n) throw error("Grids differ");
+    for (int i = 0; i < n; i++) {
+        Cell &c = cellno(i);
+        if (c.isinside() && !c.islocked())
+            c.setsymbol(g.cellno(i).getsymbol());
+    }
+}
+
+void Grid::attachdomains(BitDict &d) {
+    // single cells are not words; the dictionaries allow any letter
+    for (unsigned i = 0; i < wbl.size(); i++)
+        wbl[i]->setdomain(wbl[i]->length() > 1 ? new SlotDomain(d, wbl[i]->length()) : 0);
+}
+
+void Grid::detachdomains() {
+    for (unsigned i = 0; i < wbl.size(); i++)
+        wbl[i]->setdomain(0);
+}
+
+//////////////////////////////////////////////////////////////////////
+// class slotfilter
+
+SlotFilter::SlotFilter(Grid &g) {
+    for (int len = 0; len < MAXWORDLEN; len++) open[len] = false;
+
+    Symbol word[MAXWORDLEN];
+    int nwb = g.numwordblocks();
+    for (int i = 0; i < nwb; i++) {
+        WordBlock &wb = g.wordblock(i);
+        int len = wb.length();
+        // single cells are not words, see Grid::attachdomains
+        if (len < 2 || len >= MAXWORDLEN || open[len]) continue;
+        wb.getword(word);
+        bool locked = false;
+        for (int p = 0; p < len; p++)
+            if (!(word[p] == Symbol::empty)) locked = true;
+        if (!locked) {
+            open[len] = true;
+            patterns[len].clear();
+            continue;
+        }
+        std::vector<Symbol> pat(word, word + len);
+        bool seen = false;
+        for (unsigned j = 0; j < patterns[len].size() && !seen; j++)
+            seen = patterns[len][j] == pat;
+        if (!seen)
+            patterns[len].push_back(pat);
+    }
+}
+
+bool SlotFilter::fits(Symbol *st) {
+    int len = wordlen(st);
+    if (len >= MAXWORDLEN) return false;
+    if (open[len]) return true;
+    for (unsigned i = 0; i < patterns[len].size(); i++) {
+        std::vector<Symbol> &pat = patterns[len][i];
+        int p = 0;
+        while (p < len && (pat[p] == Symbol::empty || pat[p] == st[p])) p++;
+        if (p == len) return true;
+    }
+    return false;
+}
+
 int Grid::getempty() {
     int n = 0;
     int ncells = numcells();
@@ -34,6 +34,8 @@
 class Cell;
 class WordBlock;
 class Grid;
+class BitDict;
+class SlotDomain;
 struct WordRef {
     int pos;
     WordBlock *wbl;
@@ -45,6 +47,7 @@ class Cell {
     Symbol symb;
     Symbol preferred;
     bool locked;
+    void changed(Symbol old);
 public:
     static Cell outside_cell;
 
@@ -56,7 +59,7 @@ public:
     int numwords() { return wbl_size; }
     WordBlock &getwordblock(int wordno) { return *wbl[wordno].wbl; }
     int getpos(int wordno) { return wbl[wordno].pos; }
-    void clearwords() { wbl.clear(); }
+    void clearwords() { wbl.clear(); wbl_size = 0; }
 
     Symbol getsymbol() { return symb; }
     Symbol getpreferred() { return preferred; }
@@ -82,8 +85,6 @@ public:
 
     SymbolSet findpossible(Dict &d);
 
-    friend std::ostream&operator<<(std::ostream &os, Cell &c);
-
     void dumpwords() {
         std::cout << "got " << numwords() << " words." << std::endl;
     }
@@ -95,8 +96,8 @@ public:
     // Build a mapping from cell numbers to clue numbers:
     std::unordered_map<int,int> celltoclue();
 
-    std::string tostring();
-    std::string touppercasestring();
+    std::string tostring(const Alphabet &a);
+    std::string touppercasestring(const Alphabet &a);
 };
 
 struct Coord {
@@ -129,12 +130,21 @@ class Grid {
 protected:
     std::vector<Cell> cls; int cls_size;
     std::vector<WordBlock*> wbl;
+    const Alphabet *alpha;
     void init_grid(int w, int h);
+    void clearwordblocks();
 
 public:
     bool verbose;
     int w, h;
-    Grid(int width = 4, int height = 4);
+    Grid(int width = 4, int height = 4, const Alphabet &a = Alphabet::latin());
+    // copies the cells and gives the copy word blocks of its own, so it
+    // can be filled independently, e.g. in another thread. Domains are
+    // not copied.
+    Grid(const Grid &g);
+    Grid &operator=(const Grid &) = delete;
+    ~Grid();
+    const Alphabet &alphabet() { return *alpha; }
 
     inline Cell &cellno(int n) {
         if ((n < 0)||(n >= cls_size))
@@ -171,6 +181,13 @@ public:
     void dump_ggrid(std::ostream &os);
 
     void lock();
+    // take the symbols of the open cells from g, a copy of this grid
+    void copyfill(Grid &g);
+
+    // keep a live SlotDomain in every word block, used by findpossible()
+    // when it is given the same dictionary
+    void attachdomains(BitDict &d);
+    void detachdomains();
 
     int getempty();
 
@@ -181,6 +198,8 @@ public:
     float attemptaverage();
     int numopen();
     int numcells() { return cls.size(); }
+    int numwordblocks() { return wbl.size(); }
+    WordBlock &wordblock(int i) { return *wbl[i]; }
     double dependencydegree(int level);
     int celldependencies(int cellno, int level);
 
@@ -200,8 +219,18 @@ struct CellRef {
 
 class WordBlock {
     std::vector<CellRef> cls; int cls_size;
+    // dictionary answers for the current pattern, kept until one of the
+    // cells changes. Positions are asked one at a time as needed, or
+    // all at once with Dict::findslot() when the count is wanted.
+    std::vector<SymbolSet> possible;
+    uint32_t known; // positions of possible that are valid
+    int nmatches;   // -1 if not known
+    Dict *possibledict;
+    SlotDomain *domain;
+    void usedict(Dict &d);
 public:
     WordBlock();
+    ~WordBlock();
     void addcell(int n, Grid &gr) {
         cls.push_back(CellRef(n, gr));
         cls_size++;
@@ -216,6 +245,25 @@ public:
         if ((pos < 0)||(pos >= cls_size)) return Cell::outside_cell;
         return *cls[pos].ptr();
     }
+    void invalidate() { known = 0; nmatches = -1; }
+    void setdomain(SlotDomain *sd);
+    void cellchanged(int pos, Symbol old, Symbol now);
+    SymbolSet findpossible(Dict &d, int pos);
+    int nummatches(Dict &d);
+};
+
+/**
+ * The lengths and locked letters of the word blocks of a grid. Used to
+ * index only the words that fit somewhere in the grid, instead of the
+ * whole word list.
+ */
+class SlotFilter {
+    bool open[MAXWORDLEN]; // some block of the length has no locked letter
+    std::vector<std::vector<Symbol> > patterns[MAXWORDLEN];
+public:
+    SlotFilter(Grid &g);
+    bool fits(Symbol *st);
+    bool used(int len) { return open[len] || !patterns[len].empty(); }
 };
 
 #endif // CWC_GRID_HH
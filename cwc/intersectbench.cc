@@ -0,0 +1,143 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+
+/**
+ * Microbenchmark for LetterDict::findpossible. Compares the adaptive
+ * intersection against the plain merge that advances the smallest
+ * iterator one step at a time, for patterns with an increasing number
+ * of fixed letters. Patterns are taken from words in the list, so
+ * every query has at least one match.
+ *
+ * Build and run from this directory:
+ *   g++ -O2 -o intersectbench intersectbench.cc letterdict.cc postings.cc \
+ *       wordlist.cc symbol.cc random.cc dict.cc
+ *   ./intersectbench /usr/share/dict/words
+ **/
+
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <stdlib.h>
+
+#include "letterdict.hh"
+
+struct Query {
+    Symbol s[MAXWORDLEN + 1];
+    int len, pos;
+};
+
+// the intersection LetterDict used before it was made adaptive
+static SymbolSet mergepossible(LetterDict &d, Symbol *s, int len, int pos) {
+    PostingIterator it[len];
+    int nsets = 0;
+    for (int i = 0; i < len; i++) {
+        if (s[i] != Symbol::empty) {
+            it[nsets] = d.getpostings(len, i, s[i])->begin();
+            if (it[nsets].atend())
+                return 0;
+            nsets++;
+        }
+    }
+    SymbolSet ss = 0;
+    while (1) {
+        bool allequal = true;
+        for (int i = 0; i < nsets-1; i++)
+            allequal &= (*it[i] == *it[i+1]);
+        if (allequal) {
+            ss |= (*d.wl)[*it[0]][pos].getsymbolset();
+            for (int i = 0; i < nsets; i++) {
+                it[i].next();
+                if (it[i].atend())
+                    return ss;
+            }
+        } else {
+            int sm = 0;
+            for (int i = 1; i < nsets; i++)
+                if (*it[i] < *it[sm])
+                    sm = i;
+            it[sm].next();
+            if (it[sm].atend())
+                return ss;
+        }
+    }
+}
+
+static std::vector<Query> makequeries(WordList &wl, int nfixed, int n) {
+    std::vector<Query> qs;
+    while (int(qs.size()) < n) {
+        Symbol *w = wl[rand() % wl.numwords()];
+        int len = wordlen(w);
+        if (len <= nfixed || len >= MAXWORDLEN)
+            continue;
+        Query q;
+        q.len = len;
+        for (int i = 0; i < len; i++)
+            q.s[i] = Symbol::empty;
+        q.s[len] = Symbol::outside;
+        for (int k = 0; k < nfixed; ) {
+            int i = rand() % len;
+            if (q.s[i] == Symbol::empty) {
+                q.s[i] = w[i];
+                k++;
+            }
+        }
+        do q.pos = rand() % len; while (q.s[q.pos] != Symbol::empty);
+        qs.push_back(q);
+    }
+    return qs;
+}
+
+template<class F>
+static double nsperquery(std::vector<Query> &qs, SymbolSet *out, F f) {
+    auto t0 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < qs.size(); i++)
+        out[i] = f(qs[i]);
+    auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(t1 - t0).count() / qs.size();
+}
+
+int main(int argc, char *argv[]) {
+    srand(1);
+    try {
+        LetterDict d;
+        d.load(argc > 1 ? argv[1] : DEFAULT_DICT_FILE);
+
+        const int n = 20000;
+        std::cout << "fixed  merge ns/q  adaptive ns/q  speedup" << std::endl;
+        for (int nfixed = 1; nfixed <= 6; nfixed++) {
+            std::vector<Query> qs = makequeries(*d.wl, nfixed, n);
+            std::vector<SymbolSet> a(n), b(n);
+            double tm = nsperquery(qs, &a[0], [&](Query &q) {
+                return mergepossible(d, q.s, q.len, q.pos); });
+            double ta = nsperquery(qs, &b[0], [&](Query &q) {
+                return d.findpossible(q.s, q.len, q.pos); });
+            if (a != b)
+                throw error("adaptive and merge intersections disagree");
+            std::cout << "  " << nfixed << "    " << tm << "    " << ta
+                      << "    " << tm / ta << "x" << std::endl;
+        }
+    } catch (error e) {
+        std::cout << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
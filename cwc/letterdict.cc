@@ -48,15 +48,32 @@
 // letterdict
 
 LetterDict::LetterDict() : p(0), all(0) {
+    for (int i=0; i<MAXWORDLEN; i++) {
+        counts[i] = 0;
+        tablesbuilt[i] = false;
+    }
 }
 
 LetterDict::~LetterDict()
 {
-    for (size_t i=0; i<MAXWORDLEN; i++) {
-        delete p[i];
+    if (p) {
+        for (int len=0; len<MAXWORDLEN; len++) {
+            if (p[len] == 0) continue;
+            for (int pos=0; pos<len; pos++) {
+                if (p[len][pos] == 0) continue;
+                for (int ch=0; ch<32; ch++)
+                    delete p[len][pos][ch];
+                delete[] p[len][pos];
+            }
+            delete[] p[len];
+        }
+        delete[] p;
+    }
+    if (all) {
+        for (int len=0; len<MAXWORDLEN; len++)
+            delete[] all[len];
+        delete[] all;
     }
-    delete p;
-    delete all;
 }
 
 template<class T>
@@ -68,106 +85,177 @@ T **newptrarray(int n) {
 
 void LetterDict::addword(Symbol *st, int wordi) {
     if (p == 0)
-        p = newptrarray<intvec**>(MAXWORDLEN);
+        p = newptrarray<PostingList**>(MAXWORDLEN);
     if (all == 0)
         all = newptrarray<SymbolSet>(MAXWORDLEN);
 
     int wlen = wordlen(st);
     if (p[wlen] == 0)
-        p[wlen] = newptrarray<intvec*>(wlen);
+        p[wlen] = newptrarray<PostingList*>(wlen);
 
     if (all[wlen] == 0) {
         all[wlen] = new SymbolSet[wlen];
         for (int i=0; i<wlen; i++) all[wlen][i] = 0;
     }
+    counts[wlen]++;
+    tablesbuilt[wlen] = false;
+    if (!pairrows.empty()) {
+        pairindex.clear();
+        pairrows.clear();
+    }
 
     // for each position in the word
     for (int pos=0; pos<wlen; pos++) {
         if (p[wlen][pos] == 0)
-            p[wlen][pos] = newptrarray<intvec>(32);
+            p[wlen][pos] = newptrarray<PostingList>(32);
         int chval = st[pos].symbvalue();
         if (p[wlen][pos][chval] == 0)
-            p[wlen][pos][chval] = new intvec;
-        p[wlen][pos][chval]->push_back(wordi);
+            p[wlen][pos][chval] = new PostingList;
+        p[wlen][pos][chval]->add(wordi);
 
         all[wlen][pos] |= st[pos].getsymbolset();
 
     } // pointer hell :-)
 }
 
-LetterDict::intvec LetterDict::emptyvec;
+PostingList LetterDict::emptylist;
 
-LetterDict::intvec *LetterDict::getintvec(int len, int pos, Symbol s) {
-    if (p[len] == 0) return &emptyvec;
-    if (p[len][pos] == 0) return &emptyvec;
+PostingList *LetterDict::getpostings(int len, int pos, Symbol s) {
+    if (p == 0) return &emptylist;
+    if (p[len] == 0) return &emptylist;
+    if (p[len][pos] == 0) return &emptylist;
     int chval = s.symbvalue();
-    if (p[len][pos][chval] == 0) return &emptyvec;
+    if (p[len][pos][chval] == 0) return &emptylist;
     return p[len][pos][chval];
 }
 
+void LetterDict::buildtables(int len) {
+    std::vector<SymbolSet> &t = single[len];
+    t.assign(len * 32 * len, 0);
+    for (int i=0; i<len; i++) {
+        for (int ch=0; p[len][i] && ch<32; ch++) {
+            if (p[len][i][ch] == 0) continue;
+            SymbolSet *row = &t[(i*32 + ch) * len];
+            for (PostingIterator it = p[len][i][ch]->begin(); !it.atend(); it.next()) {
+                Symbol *st = (*wl)[*it];
+                for (int j=0; j<len; j++)
+                    row[j] |= st[j].getsymbolset();
+            }
+        }
+    }
+    tablesbuilt[len] = true;
+}
+
+const SymbolSet *LetterDict::singlerow(int len, int i, int letter) {
+    if (!tablesbuilt[len])
+        buildtables(len);
+    return &single[len][(i*32 + letter) * len];
+}
+
+const SymbolSet *LetterDict::pairrow(int len, int i, Symbol a, int k, Symbol b) {
+    uint32_t key = uint32_t(len) << 20 | i << 15 | a.symbvalue() << 10 | k << 5 | b.symbvalue();
+    std::unordered_map<uint32_t, int>::iterator found = pairindex.find(key);
+    if (found != pairindex.end())
+        return &pairrows[found->second];
+
+    if (pairrows.size() >= maxpairsets) {
+        pairindex.clear();
+        pairrows.clear();
+    }
+    int at = pairrows.size();
+    pairrows.resize(at + len + 1, 0);
+    SymbolSet *row = &pairrows[at];
+    PostingIterator it[2];
+    it[0] = getpostings(len, i, a)->begin();
+    it[1] = getpostings(len, k, b)->begin();
+    intersect(it, 2, [&](int wnum) {
+        Symbol *st = (*wl)[wnum];
+        for (int j=0; j<len; j++)
+            row[j] |= st[j].getsymbolset();
+        row[len]++;
+        return true;
+    });
+    pairindex[key] = at;
+    return row;
+}
+
 SymbolSet LetterDict::findpossible(Symbol *s, int len, int pos) {
     if (len == 1) return wl->allalpha;
 
-    intvec *chpset[len];
-    int nsets = 0;
+    if (all == 0 || all[len] == 0)
+        return 0;
 
+    int fixed[MAXWORDLEN];
+    int nfixed = 0;
     for (int i=0;i<len;i++)
         if (s[i] != Symbol::empty)
-            chpset[nsets++] = getintvec(len, i, s[i]);
+            fixed[nfixed++] = i;
 
-    // cout << nsets << " sets\n";
-    if (nsets == 0) {
-        if (all[len] == 0)
-            return 0;
+    // cout << nfixed << " sets\n";
+    if (nfixed == 0) {
         // dumpset(all[len][pos]);
         return all[len][pos];
     }
+    if (nfixed == 1)
+        return singlerow(len, fixed[0], s[fixed[0]].symbvalue())[pos];
+    if (nfixed == 2)
+        return pairrow(len, fixed[0], s[fixed[0]], fixed[1], s[fixed[1]])[pos];
+
+    PostingIterator it[len];
+    for (int n=0; n<nfixed; n++)
+        it[n] = getpostings(len, fixed[n], s[fixed[n]])->begin();
 
     SymbolSet ss = 0;
+    SymbolSet full = all[len][pos];
+    intersect(it, nfixed, [&](int wnum) {
+        ss |= (*wl)[wnum][pos].getsymbolset();
+        return ss != full; // once full, no other word can add anything
+    });
+    return ss;
+}
 
-    intvec::iterator it[nsets];
-    for (int i=0;i<nsets; i++) {
-        it[i] = chpset[i]->begin();
-        if (it[i] == chpset[i]->end())
-            goto done;
-    }
+int LetterDict::findslot(Symbol *s, int len, SymbolSet *sets) {
+    if (len == 1) return Dict::findslot(s, len, sets);
 
-    // find intersection among sets
-
-    while (1) {
-        // check if all iterators point to same word
-        bool allequal = true;
-        for (int i = 0; i < nsets-1; i++)
-            allequal &= (*it[i] == *it[i+1]);
-        if (allequal) {
-            // for (int i=0; i<nsets; i++)
-            // cout << (*wl)[*it[i]] << ' ';
-            // cout << endl;
-            int wnum = *it[0];
-            ss |= (*wl)[wnum][pos].getsymbolset();
-
-            for (int i=0;i<nsets;i++) {
-                it[i]++;
-                if (it[i] == chpset[i]->end())
-                    goto done;
-            }
+    for (int i=0; i<len; i++) sets[i] = 0;
+    if (all == 0 || all[len] == 0)
+        return 0;
 
-        } else {
+    int fixed[MAXWORDLEN];
+    int nfixed = 0;
+    for (int i=0; i<len; i++)
+        if (s[i] != Symbol::empty)
+            fixed[nfixed++] = i;
 
-            // increment the smallest iterator
-            int sm = 0;
-            for (int i = 1; i < nsets; i++)
-                if (*it[i] < *it[sm])
-                    sm = i;
-            it[sm]++;
-            if (it[sm] == chpset[sm]->end())
-                break;
-        }
+    if (nfixed == 0) {
+        for (int i=0; i<len; i++) sets[i] = all[len][i];
+        return counts[len];
+    }
+    if (nfixed == 1) {
+        const SymbolSet *row = singlerow(len, fixed[0], s[fixed[0]].symbvalue());
+        for (int i=0; i<len; i++) sets[i] = row[i];
+        return getpostings(len, fixed[0], s[fixed[0]])->size();
+    }
+    if (nfixed == 2) {
+        const SymbolSet *row = pairrow(len, fixed[0], s[fixed[0]],
+                                       fixed[1], s[fixed[1]]);
+        for (int i=0; i<len; i++) sets[i] = row[i];
+        return row[len];
     }
-  done:
-    // dumpset(ss);
 
-    return ss;
+    PostingIterator it[len];
+    for (int n=0; n<nfixed; n++)
+        it[n] = getpostings(len, fixed[n], s[fixed[n]])->begin();
+
+    int n = 0;
+    intersect(it, nfixed, [&](int wnum) {
+        Symbol *st = (*wl)[wnum];
+        for (int i=0; i<len; i++)
+            sets[i] |= st[i].getsymbolset();
+        n++;
+        return true;
+    });
+    return n;
 }
 
 void LetterDict::load(const std::string &fn)
@@ -180,6 +268,76 @@ void LetterDict::load(const std::string &fn)
     int nwords = wl->numwords();
     for (int i=0; i<nwords; i++)
         addword((*wl)[i], i);
+    compact();
 
     std::cout << "ok" << std::endl;
+    report(std::cout);
+}
+
+void LetterDict::compact() {
+    for (int len=0; p && len<MAXWORDLEN; len++) {
+        if (p[len] == 0) continue;
+        for (int pos=0; pos<len; pos++) {
+            if (p[len][pos] == 0) continue;
+            for (int ch=0; ch<32; ch++)
+                if (p[len][pos][ch])
+                    p[len][pos][ch]->compact();
+        }
+    }
+}
+
+size_t LetterDict::postingbytes() {
+    size_t n = 0;
+    for (int len=0; p && len<MAXWORDLEN; len++) {
+        if (p[len] == 0) continue;
+        for (int pos=0; pos<len; pos++) {
+            if (p[len][pos] == 0) continue;
+            for (int ch=0; ch<32; ch++)
+                if (p[len][pos][ch])
+                    n += p[len][pos][ch]->bytes() + sizeof(PostingList);
+        }
+    }
+    return n;
+}
+
+size_t LetterDict::memoryusage() {
+    // the posting lists plus the pointer tables leading to them, and
+    // the answer tables
+    size_t n = postingbytes();
+    for (int len=0; len<MAXWORDLEN; len++)
+        n += single[len].capacity() * sizeof(SymbolSet);
+    n += pairrows.capacity() * sizeof(SymbolSet)
+        + pairindex.size() * (sizeof(uint32_t) + sizeof(int) + sizeof(void*))
+        + pairindex.bucket_count() * sizeof(void*);
+    if (p) n += MAXWORDLEN * sizeof(PostingList***);
+    if (all) n += MAXWORDLEN * sizeof(SymbolSet*);
+    for (int len=0; p && len<MAXWORDLEN; len++) {
+        if (p[len] == 0) continue;
+        n += len * (sizeof(PostingList**) + sizeof(SymbolSet));
+        for (int pos=0; pos<len; pos++)
+            if (p[len][pos])
+                n += 32 * sizeof(PostingList*);
+    }
+    return n;
+}
+
+void LetterDict::report(std::ostream &os) {
+    // what the same postings took as one std::vector<int> each
+    size_t raw = 0;
+    for (int len=0; p && len<MAXWORDLEN; len++) {
+        if (p[len] == 0) continue;
+        for (int pos=0; pos<len; pos++) {
+            if (p[len][pos] == 0) continue;
+            for (int ch=0; ch<32; ch++)
+                if (p[len][pos][ch])
+                    raw += p[len][pos][ch]->size() * sizeof(int) + sizeof(std::vector<int>);
+        }
+    }
+    int nwords = wl ? wl->numwords() : 0;
+    if (nwords == 0)
+        return;
+    size_t n = postingbytes();
+    os << "Posting lists: " << n << " bytes, "
+       << double(n) / nwords << " bytes/word ("
+       << double(raw) / nwords << " bytes/word uncompressed)" << std::endl;
 }
@@ -24,23 +24,48 @@
 
 #include <set>
 #include <vector>
+#include <unordered_map>
+#include <stdint.h>
 #include "symbol.hh"
 #include "dict.hh"
 #include "wordlist.hh"
+#include "postings.hh"
 
 class LetterDict : public Dict {
-    typedef std::vector<int> intvec;
-    intvec ****p;
+    PostingList ****p;
     SymbolSet **all;
-    static intvec emptyvec;
+    int counts[MAXWORDLEN];
+    static PostingList emptylist;
+
+    // Most queries fix one or two letters, and those are answered from
+    // tables instead of intersecting posting lists.
+    // single[len][(i*32 + letter)*len + j] holds the letters at j of the
+    // words with letter at i. Built for a length the first time it is
+    // asked.
+    std::vector<SymbolSet> single[MAXWORDLEN];
+    bool tablesbuilt[MAXWORDLEN];
+    // two fixed letters are remembered as they are asked: a row of len
+    // sets followed by the number of words, found through pairindex
+    std::unordered_map<uint32_t, int> pairindex;
+    std::vector<SymbolSet> pairrows;
+    static const size_t maxpairsets = 1 << 20;
+
+    void buildtables(int len);
+    const SymbolSet *singlerow(int len, int i, int letter);
+    const SymbolSet *pairrow(int len, int i, Symbol a, int k, Symbol b);
 public:
     WordList *wl = nullptr;
     LetterDict();
     ~LetterDict();
     void addword(Symbol *i, int wordi);
-    intvec *getintvec(int len, int pos, Symbol s);
+    PostingList *getpostings(int len, int pos, Symbol s);
     SymbolSet findpossible(Symbol *, int len, int pos);
+    int findslot(Symbol *s, int len, SymbolSet *sets);
     void load(const std::string &fn);
+    void compact();
+    size_t postingbytes();
+    size_t memoryusage();
+    void report(std::ostream &os);
 };
 
 #endif // CWC_LETTERDICT_HH
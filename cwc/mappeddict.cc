@@ -0,0 +1,377 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+
+#include <fstream>
+#include <vector>
+#include <algorithm>
+
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "mappeddict.hh"
+#include "letterdict.hh"
+#include "wordlist.hh"
+
+/*
+   File layout. All offsets are in bytes from the start of the file
+   and everything is 4-byte aligned.
+
+   Header
+   uint32 word offsets[nwords]     -> into the symbol area
+   uint8  symbols[]                -> symbol values, each word ended
+                                      by Symbol::outside
+   List + skips + data             -> one per (len, pos, symbol)
+*/
+
+struct MappedDict::Header {
+    char magic[4];
+    uint32_t version;
+    uint32_t filesize;
+    uint32_t nwords;
+    uint32_t words, symbols;
+    char alphabet[32];               // character of each symbol value
+    uint32_t allalpha;
+    uint32_t all[MAXWORDLEN][MAXWORDLEN];
+    uint32_t lists[MAXWORDLEN][MAXWORDLEN][32];
+};
+
+struct MappedDict::List {
+    uint32_t count;
+    uint32_t skips, data;
+};
+
+static const char magic[4] = { 'C', 'W', 'C', 'D' };
+
+//////////////////////////////////////////////////////////////////////
+// writing
+
+static uint32_t append(std::vector<uint8_t> &buf, const void *data, size_t n) {
+    while (buf.size() % 4)
+        buf.push_back(0);
+    uint32_t off = buf.size();
+    const uint8_t *p = (const uint8_t *)data;
+    buf.insert(buf.end(), p, p + n);
+    return off;
+}
+
+void MappedDict::write(const std::string &fn, WordList &wl, LetterDict &d) {
+    std::vector<uint8_t> buf(sizeof(Header));
+    Header h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, magic, 4);
+    h.version = version;
+    h.nwords = wl.numwords();
+    for (int i = 0; i < 32; i++)
+        h.alphabet[i] = wl.alphabet().letter(Symbol::symbolbit(SymbolSet(1) << i));
+    h.allalpha = wl.allalpha;
+
+    std::vector<uint32_t> words;
+    std::vector<uint8_t> symbols;
+    for (int i = 0; i < wl.numwords(); i++) {
+        words.push_back(symbols.size());
+        Symbol *st = wl[i];
+        int len = wordlen(st);
+        for (int pos = 0; pos <= len; pos++)
+            symbols.push_back(st[pos].symbvalue());
+        if (len < MAXWORDLEN)
+            for (int pos = 0; pos < len; pos++)
+                h.all[len][pos] |= st[pos].getsymbolset();
+    }
+    h.words = append(buf, words.data(), words.size() * sizeof(uint32_t));
+    h.symbols = append(buf, symbols.data(), symbols.size());
+
+    for (int len = 2; len < MAXWORDLEN; len++) {
+        for (int pos = 0; pos < len; pos++) {
+            for (int ch = 0; ch < 32; ch++) {
+                PostingList *pl = d.getpostings(len, pos, Symbol::symbolbit(SymbolSet(1) << ch));
+                if (pl->size() == 0)
+                    continue;
+                const std::vector<PostingSkip> &skips = pl->rawskips();
+                const std::vector<uint8_t> &data = pl->rawdata();
+                List l;
+                l.count = pl->size();
+                l.skips = append(buf, skips.data(), skips.size() * sizeof(PostingSkip));
+                l.data = append(buf, data.data(), data.size());
+                h.lists[len][pos][ch] = append(buf, &l, sizeof(l));
+            }
+        }
+    }
+    h.filesize = buf.size();
+    memcpy(&buf[0], &h, sizeof(h));
+
+    std::ofstream f(fn.c_str(), std::ios::binary);
+    if (!f.is_open()) throw error("Failed to open file");
+    f.write((const char *)buf.data(), buf.size());
+    if (!f) throw error("Failed to write compiled dictionary");
+}
+
+//////////////////////////////////////////////////////////////////////
+// mappeddict
+
+// n bytes at off lie within a file of size bytes
+static bool inside(size_t off, size_t n, size_t size) {
+    return off <= size && n <= size - off;
+}
+
+MappedDict::MappedDict(const Alphabet &a)
+    : base(0), length(0), mapped(false), hdr(0), identity(true), alpha(a) {
+}
+
+MappedDict::~MappedDict() {
+    release();
+}
+
+void MappedDict::release() {
+    if (mapped)
+        munmap((void *)base, length);
+    base = 0;
+    hdr = 0;
+    mapped = false;
+}
+
+void MappedDict::load(const std::string &fn) {
+    int fd = open(fn.c_str(), O_RDONLY);
+    if (fd < 0) throw error("Failed to open file");
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size < off_t(sizeof(Header))) {
+        close(fd);
+        throw error("Not a compiled dictionary");
+    }
+    void *p = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) throw error("Failed to map dictionary");
+    try {
+        attach(p, st.st_size);
+    } catch (...) {
+        munmap(p, st.st_size);
+        throw;
+    }
+    mapped = true;
+}
+
+// Reads all a query may read, once: the word table, every word up
+// to its end, and every posting list in full. Each word number must be
+// in range and name a word of the list's length with the list's letter
+// at its position.
+void MappedDict::verify(const uint8_t *data, size_t size) {
+    const Header *h = (const Header *)data;
+    if (h->words % 4 != 0 || !inside(h->words, size_t(h->nwords) * sizeof(uint32_t), size)
+        || !inside(h->symbols, 1, size))
+        throw error("Corrupt compiled dictionary");
+
+    const uint32_t *words = (const uint32_t *)(data + h->words);
+    const uint8_t *symbols = data + h->symbols;
+    size_t nsymbols = size - h->symbols;
+    // letters are shift counts, so below 32, and each word ends with
+    // Symbol::outside
+    const int outside = Symbol::outside.symbvalue();
+    std::vector<uint8_t> lens(h->nwords);
+    for (uint32_t i = 0; i < h->nwords; i++) {
+        size_t p = words[i];
+        int len = 0;
+        while (p < nsymbols && symbols[p] > outside && symbols[p] < 32) {
+            p++;
+            len++;
+        }
+        if (p >= nsymbols || symbols[p] != outside)
+            throw error("Corrupt compiled dictionary");
+        lens[i] = std::min(len, int(MAXWORDLEN));
+    }
+
+    for (int len = 0; len < MAXWORDLEN; len++) {
+        for (int pos = 0; pos < MAXWORDLEN; pos++) {
+            for (int ch = 0; ch < 32; ch++) {
+                uint32_t off = h->lists[len][pos][ch];
+                if (off == 0)
+                    continue;
+                if (len < 2 || pos >= len || off % 4 != 0 || !inside(off, sizeof(List), size))
+                    throw error("Corrupt compiled dictionary");
+                const List *l = (const List *)(data + off);
+                size_t nskips = (size_t(l->count) + PostingIterator::blocksize - 1)
+                    / PostingIterator::blocksize;
+                if (l->count > h->nwords || l->skips % 4 != 0
+                    || !inside(l->skips, nskips * sizeof(PostingSkip), size) || l->data > size)
+                    throw error("Corrupt compiled dictionary");
+                const PostingSkip *skips = (const PostingSkip *)(data + l->skips);
+                // decoded as PostingIterator does, with every byte in the
+                // file and every value rising
+                int64_t last = -1;
+                for (size_t b = 0; b < nskips; b++) {
+                    size_t n = std::min(size_t(PostingIterator::blocksize),
+                                        l->count - b * PostingIterator::blocksize);
+                    size_t p = size_t(l->data) + skips[b].offset;
+                    int64_t value = skips[b].first;
+                    for (size_t k = 0; ; ) {
+                        if (value <= last || value >= h->nwords || lens[value] != len
+                            || symbols[words[value] + pos] != ch)
+                            throw error("Corrupt compiled dictionary");
+                        last = value;
+                        if (++k == n)
+                            break;
+                        uint32_t delta = 0;
+                        int shift = 0;
+                        uint8_t byte;
+                        do {
+                            if (p >= size || shift > 21)
+                                throw error("Corrupt compiled dictionary");
+                            byte = data[p++];
+                            delta |= uint32_t(byte & 0x7f) << shift;
+                            shift += 7;
+                        } while (byte & 0x80);
+                        value += delta;
+                    }
+                }
+            }
+        }
+    }
+}
+
+void MappedDict::attach(const void *data, size_t size) {
+    release();
+    const Header *h = (const Header *)data;
+    if (size < sizeof(Header) || memcmp(h->magic, magic, 4) != 0)
+        throw error("Not a compiled dictionary");
+    if (h->version != version)
+        throw error("Unsupported compiled dictionary version");
+    if (h->filesize != size)
+        throw error("Truncated compiled dictionary");
+    verify((const uint8_t *)data, size);
+    base = (const uint8_t *)data;
+    length = size;
+    hdr = h;
+
+    // the symbol values in the file need not match the ones of our
+    // alphabet. Letters we do not have are never asked for.
+    for (int len = 0; len < MAXWORDLEN; len++) {
+        counts[len] = 0;
+        for (int ch = 0; len > 0 && ch < 32; ch++)
+            counts[len] += postings(len, 0, ch).size();
+    }
+
+    identity = true;
+    for (int i = 0; i < 32; i++)
+        tofile[i] = fromfile[i] = -1;
+    for (int v = 0; v < 32; v++) {
+        if (hdr->alphabet[v] == UNDEF)
+            continue;
+        int r = alpha.symbol(hdr->alphabet[v]).symbvalue();
+        if (r == UNDEF) {
+            identity = false;
+            continue;
+        }
+        tofile[r] = v;
+        fromfile[v] = r;
+        if (r != v)
+            identity = false;
+    }
+}
+
+int MappedDict::numwords() {
+    return hdr ? hdr->nwords : 0;
+}
+
+SymbolSet MappedDict::fromfileset(SymbolSet ss) {
+    if (identity)
+        return ss;
+    SymbolSet r = 0;
+    for (int v = 0; ss; v++, ss >>= 1)
+        if ((ss & 1) && fromfile[v] >= 0)
+            r |= SymbolSet(1) << fromfile[v];
+    return r;
+}
+
+PostingIterator MappedDict::postings(int len, int pos, int filesymb) {
+    uint32_t off = hdr->lists[len][pos][filesymb];
+    if (off == 0)
+        return PostingIterator();
+    const List *l = (const List *)(base + off);
+    return PostingIterator(base + l->data, (const PostingSkip *)(base + l->skips), l->count);
+}
+
+SymbolSet MappedDict::findpossible(Symbol *s, int len, int pos) {
+    if (hdr == 0) throw error("No dictionary loaded");
+    if (len >= MAXWORDLEN) return 0;
+    if (len == 1) return fromfileset(hdr->allalpha);
+
+    PostingIterator it[len];
+    int nsets = 0;
+    for (int i = 0; i < len; i++) {
+        if (s[i] != Symbol::empty) {
+            int v = tofile[s[i].symbvalue()];
+            if (v < 0)
+                return 0;
+            it[nsets++] = postings(len, i, v);
+        }
+    }
+    if (nsets == 0)
+        return fromfileset(hdr->all[len][pos]);
+
+    const uint32_t *words = (const uint32_t *)(base + hdr->words);
+    const uint8_t *symbols = base + hdr->symbols;
+    SymbolSet ss = 0;
+    SymbolSet full = hdr->all[len][pos];
+    intersect(it, nsets, [&](int wnum) {
+        ss |= SymbolSet(1) << symbols[words[wnum] + pos];
+        return ss != full;
+    });
+    return fromfileset(ss);
+}
+
+int MappedDict::findslot(Symbol *s, int len, SymbolSet *sets) {
+    if (hdr == 0) throw error("No dictionary loaded");
+    if (len == 1 || len >= MAXWORDLEN) return Dict::findslot(s, len, sets);
+
+    for (int i = 0; i < len; i++)
+        sets[i] = 0;
+    PostingIterator it[len];
+    int nsets = 0;
+    for (int i = 0; i < len; i++) {
+        if (s[i] != Symbol::empty) {
+            int v = tofile[s[i].symbvalue()];
+            if (v < 0)
+                return 0;
+            it[nsets++] = postings(len, i, v);
+        }
+    }
+    if (nsets == 0) {
+        for (int i = 0; i < len; i++)
+            sets[i] = fromfileset(hdr->all[len][i]);
+        return counts[len];
+    }
+
+    const uint32_t *words = (const uint32_t *)(base + hdr->words);
+    const uint8_t *symbols = base + hdr->symbols;
+    int n = 0;
+    intersect(it, nsets, [&](int wnum) {
+        const uint8_t *st = symbols + words[wnum];
+        for (int i = 0; i < len; i++)
+            sets[i] |= SymbolSet(1) << st[i];
+        n++;
+        return true;
+    });
+    for (int i = 0; i < len; i++)
+        sets[i] = fromfileset(sets[i]);
+    return n;
+}
@@ -0,0 +1,78 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+
+#ifndef CWC_MAPPEDDICT_HH
+#define CWC_MAPPEDDICT_HH
+
+#include <stddef.h>
+#include <stdint.h>
+#include "symbol.hh"
+#include "dict.hh"
+#include "postings.hh"
+
+class WordList;
+class LetterDict;
+
+/**
+ * Dictionary served straight from a precompiled file, see
+ * dictcompile.cc. The file holds the word list and the LetterDict
+ * posting lists, addressed by offsets from the start of the file, so
+ * it can be mapped anywhere and used without copying or building
+ * anything. It is only read through once, to check it.
+ */
+
+class MappedDict : public Dict {
+    struct Header;
+    struct List;
+    const uint8_t *base;
+    size_t length;
+    bool mapped;
+    const Header *hdr;
+    int tofile[32], fromfile[32];
+    int counts[MAXWORDLEN];
+    bool identity;
+    const Alphabet &alpha;
+
+    void release();
+    static void verify(const uint8_t *data, size_t size);
+    PostingIterator postings(int len, int pos, int filesymb);
+    SymbolSet fromfileset(SymbolSet ss);
+public:
+    static const uint32_t version = 1;
+
+    MappedDict(const Alphabet &a = Alphabet::latin());
+    ~MappedDict();
+
+    // write the words of wl and the indexes d has built from them
+    static void write(const std::string &fn, WordList &wl, LetterDict &d);
+
+    // both throw on a file that is not a well formed dictionary, so
+    // no query can read outside it
+    void load(const std::string &fn);
+    void attach(const void *data, size_t size);
+    int numwords();
+    size_t memoryusage() { return length; }
+    SymbolSet findpossible(Symbol *s, int len, int pos);
+    int findslot(Symbol *s, int len, SymbolSet *sets);
+};
+
+#endif // CWC_MAPPEDDICT_HH
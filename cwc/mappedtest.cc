@@ -0,0 +1,223 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+
+/**
+ * Checks that MappedDict refuses damaged files. Compiles the first
+ * words of a list, checks the intact file against a LetterDict, then
+ * attaches damaged copies: truncated, with a word offset, a letter or
+ * a posting byte broken on purpose, and with random bytes flipped. The
+ * deliberate damage must be rejected. Any other copy must either be
+ * rejected or answer queries; each copy sits in a buffer of its own
+ * size, so built with -fsanitize=address a read outside it stops the
+ * run. The word list keeps its words until the program ends, hence no
+ * leak check.
+ *
+ * Build and run from this directory:
+ *   g++ -O1 -g -fsanitize=address -o mappedtest mappedtest.cc \
+ *       mappeddict.cc letterdict.cc postings.cc wordlist.cc symbol.cc \
+ *       random.cc dict.cc
+ *   ASAN_OPTIONS=detect_leaks=0 ./mappedtest /usr/share/dict/words
+ **/
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "letterdict.hh"
+#include "mappeddict.hh"
+#include "wordlist.hh"
+
+namespace {
+
+struct Query {
+    Symbol s[MAXWORDLEN + 1];
+    int len, pos;
+};
+
+// patterns taken from words of the list, a few letters of each fixed
+std::vector<Query> makequeries(WordList &wl, Random &rng, int n) {
+    std::vector<Query> qs;
+    while (int(qs.size()) < n) {
+        Symbol *w = wl[rng.below(wl.numwords())];
+        int len = wordlen(w);
+        if (len < 2 || len >= MAXWORDLEN)
+            continue;
+        Query q;
+        q.len = len;
+        for (int i = 0; i < len; i++)
+            q.s[i] = rng.below(3) == 0 ? w[i] : Symbol::empty;
+        q.s[len] = Symbol::outside;
+        q.pos = rng.below(len);
+        q.s[q.pos] = Symbol::empty;
+        qs.push_back(q);
+    }
+    return qs;
+}
+
+// attach a copy of file, answering the queries if it loads; false if
+// it was rejected
+bool tryload(const std::vector<uint8_t> &file, std::vector<Query> &qs) {
+    std::vector<uint8_t> copy(file);
+    MappedDict d;
+    try {
+        d.attach(copy.data(), copy.size());
+    } catch (error &e) {
+        return false;
+    }
+    SymbolSet sets[MAXWORDLEN];
+    for (size_t i = 0; i < qs.size(); i++) {
+        d.findpossible(qs[i].s, qs[i].len, qs[i].pos);
+        d.findslot(qs[i].s, qs[i].len, sets);
+    }
+    return true;
+}
+
+void expectrejected(const std::vector<uint8_t> &file, std::vector<Query> &qs, const char *what) {
+    if (tryload(file, qs))
+        throw error(std::string("accepted a file with ") + what);
+}
+
+uint32_t get32(const std::vector<uint8_t> &file, size_t off) {
+    uint32_t v;
+    memcpy(&v, &file[off], 4);
+    return v;
+}
+
+void put32(std::vector<uint8_t> &file, size_t off, uint32_t v) {
+    memcpy(&file[off], &v, 4);
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    try {
+        WordList wl;
+        {
+            std::ifstream f(argc > 1 ? argv[1] : DEFAULT_DICT_FILE);
+            if (!f.is_open()) throw error("Failed to open file");
+            std::string line;
+            while (wl.numwords() < 3000 && std::getline(f, line))
+                wl.addWord(line);
+        }
+        LetterDict ld;
+        ld.wl = &wl;
+        for (int i = 0; i < wl.numwords(); i++)
+            ld.addword(wl[i], i);
+
+        char fn[] = "/tmp/mappedtestXXXXXX";
+        int fd = mkstemp(fn);
+        if (fd < 0) throw error("Failed to create temporary file");
+        close(fd);
+        MappedDict::write(fn, wl, ld);
+        std::vector<uint8_t> file;
+        {
+            std::ifstream f(fn, std::ios::binary);
+            file.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+        }
+        remove(fn);
+
+        Random rng;
+        rng.setseed(1);
+        std::vector<Query> qs = makequeries(wl, rng, 200);
+
+        // the intact file answers as the dictionary it came from
+        {
+            std::vector<uint8_t> copy(file);
+            MappedDict d;
+            d.attach(copy.data(), copy.size());
+            for (size_t i = 0; i < qs.size(); i++)
+                if (d.findpossible(qs[i].s, qs[i].len, qs[i].pos)
+                    != ld.findpossible(qs[i].s, qs[i].len, qs[i].pos))
+                    throw error("intact file answers differently");
+        }
+
+        // the header fields, see the layout in mappeddict.cc
+        const size_t nwordsat = 12, wordsat = 16, symbolsat = 20;
+        const size_t listsat = 24 + 32 + 4 + 4 * MAXWORDLEN * MAXWORDLEN;
+        uint32_t words = get32(file, wordsat), symbols = get32(file, symbolsat);
+
+        std::vector<uint8_t> bad(file);
+        bad.resize(file.size() - 1);
+        put32(bad, 8, bad.size());
+        expectrejected(bad, qs, "its last byte cut off");
+
+        bad = file;
+        put32(bad, nwordsat, get32(file, nwordsat) + 1000);
+        expectrejected(bad, qs, "too many words");
+
+        bad = file;
+        put32(bad, words + 4 * (wl.numwords() / 2), file.size());
+        expectrejected(bad, qs, "a word offset past the end");
+
+        bad = file;
+        bad[symbols + get32(file, words + 4)] = 40;
+        expectrejected(bad, qs, "a letter that is no symbol");
+
+        // the first list with more than one block: a varint that runs
+        // on, and a skip entry past the last word
+        size_t list = 0;
+        for (size_t off = listsat; off < listsat + 4 * MAXWORDLEN * MAXWORDLEN * 32; off += 4) {
+            uint32_t l = get32(file, off);
+            if (l && get32(file, l) > PostingIterator::blocksize) {
+                list = l;
+                break;
+            }
+        }
+        if (list == 0) throw error("word list too short for a test");
+        bad = file;
+        uint32_t data = get32(file, list + 8);
+        for (size_t p = data; p < file.size(); p++)
+            bad[p] |= 0x80;
+        expectrejected(bad, qs, "a varint that never ends");
+        bad = file;
+        put32(bad, get32(file, list + 4) + 8, wl.numwords());
+        expectrejected(bad, qs, "a posting past the last word");
+
+        // random damage, half of it past the header where the words
+        // and lists are
+        const size_t hdrsize = listsat + 4 * MAXWORDLEN * MAXWORDLEN * 32;
+        long rejected = 0, accepted = 0;
+        for (int i = 0; i < 2000; i++) {
+            bad = file;
+            for (int k = 1 + rng.below(3); k > 0; k--) {
+                size_t p = i % 2 ? rng.below(file.size()) : hdrsize + rng.below(file.size() - hdrsize);
+                bad[p] ^= 1 << rng.below(8);
+            }
+            if (tryload(bad, qs))
+                accepted++;
+            else
+                rejected++;
+        }
+        std::cout << "random damage: " << rejected << " rejected, " << accepted
+                  << " answered safely" << std::endl;
+    } catch (error e) {
+        std::cout << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout << "ok" << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,161 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+
+#include "nogood.hh"
+
+//////////////////////////////////////////////////////////////////////
+// nogoodstore
+
+NogoodStore::NogoodStore(int cap)
+    : capacity(cap), hand(0), stored(0), hits(0), evictions(0), saved(0),
+      maxcells(16) {
+    if (capacity < 1)
+        capacity = 1;
+    entries.reserve(capacity);
+    index.reserve(capacity);
+}
+
+// the block, the positions, then their symbols
+std::string NogoodStore::makekey(WordBlock &wb, uint32_t positions) {
+    WordBlock *p = &wb;
+    std::string k(reinterpret_cast<const char *>(&p), sizeof(p));
+    k.append(reinterpret_cast<const char *>(&positions), sizeof(positions));
+    int len = wb.length();
+    for (int i = 0; i < len; i++)
+        if (positions & (1u << i))
+            k += char(wb.getcell(i).getsymbol().symbvalue());
+    return k;
+}
+
+bool NogoodStore::find(Grid &g, WordBlock &wb, int pos, std::vector<int> &cells) {
+    std::unordered_map<WordBlock *, Masks>::iterator b = perblock.find(&wb);
+    if (b == perblock.end())
+        return false;
+    Masks &masks = b->second;
+    for (unsigned m = 0; m < masks.size(); m++) {
+        uint32_t positions = masks[m].first;
+        if (!(positions & (1u << pos)))
+            continue;
+        std::unordered_map<std::string, int>::iterator i = index.find(makekey(wb, positions));
+        if (i == index.end())
+            continue;
+        Entry &e = entries[i->second];
+        bool match = true;
+        for (unsigned c = 0; c < e.cells.size() && match; c++)
+            match = g.cellno(e.cells[c]).getsymbol() == e.symbols[c];
+        if (!match)
+            continue;
+        hits++;
+        e.referenced = true;
+        saved += e.cost;
+        int len = wb.length();
+        for (int p = 0; p < len; p++)
+            if (positions & (1u << p))
+                cells.push_back(wb.getcellno(p));
+        cells.insert(cells.end(), e.cells.begin(), e.cells.end());
+        return true;
+    }
+    return false;
+}
+
+void NogoodStore::unfile(Entry &e) {
+    index.erase(e.key);
+    Masks &masks = perblock[e.block];
+    for (unsigned m = 0; m < masks.size(); m++) {
+        if (masks[m].first == e.positions && --masks[m].second == 0) {
+            masks.erase(masks.begin() + m);
+            break;
+        }
+    }
+    if (masks.empty())
+        perblock.erase(e.block);
+}
+
+void NogoodStore::add(Grid &g, WordBlock &wb, uint32_t positions,
+                      const std::vector<int> &outside, long cost) {
+    if (__builtin_popcount(positions) + int(outside.size()) > maxcells)
+        return;
+    std::string k = makekey(wb, positions);
+    if (index.count(k))
+        return;
+    stored++;
+
+    int slot;
+    if (entries.size() < capacity) {
+        slot = entries.size();
+        entries.push_back(Entry());
+    } else {
+        // advance the clock hand to an entry not used since last pass
+        while (entries[hand].referenced) {
+            entries[hand].referenced = false;
+            hand = (hand + 1) % capacity;
+        }
+        slot = hand;
+        hand = (hand + 1) % capacity;
+        unfile(entries[slot]);
+        evictions++;
+    }
+    Entry &e = entries[slot];
+    e.key = k;
+    e.block = &wb;
+    e.positions = positions;
+    e.cells = outside;
+    e.symbols.clear();
+    for (unsigned c = 0; c < outside.size(); c++)
+        e.symbols.push_back(g.cellno(outside[c]).getsymbol());
+    e.cost = cost;
+    e.referenced = false;
+    index[k] = slot;
+
+    Masks &masks = perblock[&wb];
+    unsigned m = 0;
+    while (m < masks.size() && masks[m].first != positions)
+        m++;
+    if (m == masks.size())
+        masks.push_back(std::make_pair(positions, 0));
+    masks[m].second++;
+}
+
+void NogoodStore::clear() {
+    entries.clear();
+    index.clear();
+    perblock.clear();
+    hand = 0;
+}
+
+size_t NogoodStore::memoryusage() {
+    size_t bytes = entries.capacity() * sizeof(Entry);
+    for (unsigned i = 0; i < entries.size(); i++)
+        bytes += 2 * entries[i].key.capacity()
+            + entries[i].cells.capacity() * sizeof(int)
+            + entries[i].symbols.capacity() * sizeof(Symbol);
+    bytes += index.bucket_count() * sizeof(void*)
+        + index.size() * (sizeof(std::string) + sizeof(int) + sizeof(void*));
+    for (std::unordered_map<WordBlock *, Masks>::iterator b = perblock.begin(); b != perblock.end(); b++)
+        bytes += sizeof(*b) + sizeof(void*) + b->second.capacity() * sizeof(Masks::value_type);
+    return bytes;
+}
+
+void NogoodStore::report(std::ostream &os) {
+    os << "Nogoods: " << stored << " learned, " << hits << " reused, "
+       << evictions << " evictions, " << saved << " nodes saved" << std::endl;
+}
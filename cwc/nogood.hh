@@ -0,0 +1,85 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+
+#ifndef CWC_NOGOOD_HH
+#define CWC_NOGOOD_HH
+
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <iostream>
+#include <stdint.h>
+#include "grid.hh"
+
+/**
+ * Partial fills known to have no fill of the grid around them, learned
+ * from conflict sets. A nogood is filed under one of its word blocks,
+ * hashed by the block and the letters of the positions it fixes there;
+ * the few cells it fixes elsewhere are checked when the key matches.
+ * So a letter brings back a nogood when one of its words reads as a
+ * stored pattern, whatever the rest of the word holds.
+ *
+ * The store holds a fixed number of nogoods and replaces them with the
+ * CLOCK policy, as CachedDict does. Each nogood remembers the nodes it
+ * took to find; saved adds that up for every time it is found again.
+ */
+
+class NogoodStore {
+    struct Entry {
+        std::string key;
+        WordBlock *block;
+        uint32_t positions;
+        std::vector<int> cells;       // fixed outside the block
+        std::vector<Symbol> symbols;  // and their letters
+        long cost;
+        bool referenced;
+    };
+    // the position sets filed under a block, with how many use each
+    typedef std::vector<std::pair<uint32_t, int> > Masks;
+
+    size_t capacity;
+    std::vector<Entry> entries;
+    std::unordered_map<std::string, int> index;
+    std::unordered_map<WordBlock *, Masks> perblock;
+    size_t hand;
+
+    static std::string makekey(WordBlock &wb, uint32_t positions);
+    void unfile(Entry &e);
+public:
+    long stored, hits, evictions, saved;
+    // nogoods fixing more cells than this are not kept
+    int maxcells;
+
+    NogoodStore(int capacity = 16384);
+    /**
+     * a nogood filed under wb whose positions include pos and that
+     * the grid now matches, with all its cells added to cells
+     */
+    bool find(Grid &g, WordBlock &wb, int pos, std::vector<int> &cells);
+    // positions of wb as they read now, and the cells outside it
+    void add(Grid &g, WordBlock &wb, uint32_t positions, const std::vector<int> &outside, long cost);
+    void clear();
+    size_t memoryusage();
+    void report(std::ostream &os);
+};
+
+#endif // CWC_NOGOOD_HH
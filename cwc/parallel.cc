@@ -0,0 +1,168 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+
+#include <thread>
+
+#include "parallel.hh"
+
+//////////////////////////////////////////////////////////////////////
+// class parallelcompiler
+
+ParallelCompiler::ParallelCompiler(Grid &thegrid, Dict &thedict, int n)
+    : g(thegrid), d(thedict), domaindict(0), nthreads(n),
+      pending(0), done(false), solutions(0), winner(-1),
+      findall(false), propagation(false), splitdepth(3) {
+    if (nthreads <= 0)
+        nthreads = std::thread::hardware_concurrency();
+    if (nthreads <= 0)
+        nthreads = 1;
+    for (int i = 0; i < nthreads; i++) {
+        workers.push_back(new Worker);
+        workers[i]->pc = this;
+    }
+}
+
+ParallelCompiler::~ParallelCompiler() {
+    for (int i = 0; i < nthreads; i++)
+        delete workers[i];
+}
+
+void ParallelCompiler::Worker::split(const Task &prefix) {
+    pc->pending++;
+    std::lock_guard<std::mutex> l(lock);
+    tasks.push_back(prefix);
+}
+
+// newest own task, else the oldest of some other worker, starting at
+// a random one so that thieves spread out
+bool ParallelCompiler::take(int i, Task &t) {
+    Worker &me = *workers[i];
+    {
+        std::lock_guard<std::mutex> l(me.lock);
+        if (!me.tasks.empty()) {
+            t.swap(me.tasks.back());
+            me.tasks.pop_back();
+            return true;
+        }
+    }
+    int start = me.rng.below(nthreads);
+    for (int k = 0; k < nthreads; k++) {
+        Worker &victim = *workers[(start + k) % nthreads];
+        if (&victim == &me) continue;
+        std::lock_guard<std::mutex> l(victim.lock);
+        if (!victim.tasks.empty()) {
+            t.swap(victim.tasks.front());
+            victim.tasks.pop_front();
+            me.nsteals++;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ParallelCompiler::run(int i, const Grid &base) {
+    Worker &me = *workers[i];
+    Task t;
+    // a task is pending until it is searched, and the branches it
+    // splits off are queued before that, so none left means done
+    while (!done && pending > 0) {
+        if (!take(i, t)) {
+            std::this_thread::yield();
+            continue;
+        }
+        try {
+            Grid mine(base);
+            if (domaindict)
+                mine.attachdomains(*domaindict);
+            // the order depends only on what is filled, so a prefix
+            // leads back to the same cell
+            MRVWalker w(mine, d);
+            // see Compiler::tryletter about findall; the smart
+            // backtracker could skip fills, so finding none would
+            // prove nothing
+            NaiveBacktracker nbt(mine);
+            ConflictBacktracker cbt(mine);
+            Compiler c(mine, w, findall ? (Backtracker &)nbt : (Backtracker &)cbt, d);
+            c.findall = findall;
+            c.propagation = propagation;
+            c.setseed(me.rng.next());
+            c.setcancel(&done);
+            c.setsplitter(&me, splitdepth);
+            me.ntasks++;
+            bool ok = c.compile(t);
+            solutions += c.getsolutions();
+            if (ok && !findall && !done.exchange(true)) {
+                winner = i;
+                g.copyfill(mine);
+            }
+            mine.detachdomains();
+        } catch (error &e) {
+            // the grid is the same for every task, so is the error
+            if (!done.exchange(true))
+                failure = e.what();
+        } catch (...) {
+            if (!done.exchange(true))
+                failure = "Compiler thread failed";
+        }
+        pending--;
+    }
+}
+
+bool ParallelCompiler::compile() {
+    winner = -1;
+    failure.clear();
+    solutions = 0;
+    done = false;
+    for (int i = 0; i < nthreads; i++) {
+        workers[i]->tasks.clear();
+        workers[i]->rng.setseed(rng.next());
+        workers[i]->ntasks = workers[i]->nsteals = 0;
+    }
+
+    // the workers copy this one, g is only written by the winner
+    Grid base(g);
+    workers[0]->tasks.push_back(Task());
+    pending = 1;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < nthreads; i++)
+        threads.push_back(std::thread(&ParallelCompiler::run, this, i, std::cref(base)));
+    for (int i = 0; i < nthreads; i++)
+        threads[i].join();
+
+    if (winner < 0 && !failure.empty())
+        throw error(failure);
+    return findall ? solutions > 0 : winner >= 0;
+}
+
+long ParallelCompiler::numtasks() {
+    long n = 0;
+    for (int i = 0; i < nthreads; i++)
+        n += workers[i]->ntasks;
+    return n;
+}
+
+long ParallelCompiler::numsteals() {
+    long n = 0;
+    for (int i = 0; i < nthreads; i++)
+        n += workers[i]->nsteals;
+    return n;
+}
@@ -0,0 +1,106 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+
+#ifndef CWC_PARALLEL_HH
+#define CWC_PARALLEL_HH
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <mutex>
+#include <atomic>
+#include <stdint.h>
+#include "grid.hh"
+#include "dict.hh"
+#include "random.hh"
+#include "cwc.hh"
+
+class BitDict;
+
+/**
+ * Searches one tree on several threads. The branches of the first few
+ * steps become tasks, each a prefix of symbols (see Splitter); a worker
+ * searches a task on a fresh copy of the grid and queues the branches
+ * it splits off in turn. Workers take their own newest tasks first and,
+ * when out of work, steal the oldest, largest ones of another worker.
+ *
+ * Unlike a Portfolio, the workers never search the same branch twice,
+ * so this also pays off when the whole tree has to be searched: with
+ * findall, or to show that a grid has no fill. A task jumps back by
+ * conflict sets. The cells it may jump past near its root gave their
+ * other letters away as tasks, so it skips no fill either.
+ *
+ * As with a Portfolio the dictionary must be safe to query from
+ * several threads at once.
+ */
+
+class ParallelCompiler {
+    typedef std::vector<Symbol> Task;
+
+    class Worker : public Splitter {
+    public:
+        ParallelCompiler *pc;
+        std::mutex lock;
+        std::deque<Task> tasks;
+        Random rng;
+        long ntasks, nsteals;
+        void split(const Task &prefix) override;
+    };
+
+    Grid &g;
+    Dict &d;
+    BitDict *domaindict;
+    int nthreads;
+    Random rng;
+    std::vector<Worker *> workers;
+    std::atomic<long> pending;
+    std::atomic<bool> done;
+    std::atomic<long> solutions;
+    int winner;
+    std::string failure;
+
+    bool take(int i, Task &t);
+    void run(int i, const Grid &base);
+public:
+    // nthreads 0 means one per core
+    ParallelCompiler(Grid &thegrid, Dict &thedict, int nthreads = 0);
+    ~ParallelCompiler();
+    // give every copy slot domains over bd, see Grid::attachdomains
+    void usedomains(BitDict &bd) { domaindict = &bd; }
+    void setseed(uint64_t seed) { rng.setseed(seed); }
+    int numthreads() { return nthreads; }
+    bool compile();
+
+    // count every fill instead of stopping at the first; the grid is
+    // then left as it was
+    bool findall;
+    // see Compiler::propagation
+    bool propagation;
+    // the steps whose branches become tasks
+    int splitdepth;
+    long getsolutions() { return solutions; }
+    int getwinner() { return winner; }
+    long numtasks();
+    long numsteals();
+};
+
+#endif // CWC_PARALLEL_HH
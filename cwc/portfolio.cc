@@ -0,0 +1,193 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+
+#include "portfolio.hh"
+#include "cwc.hh"
+#include "restart.hh"
+
+//////////////////////////////////////////////////////////////////////
+// class portfolio
+
+// what a compiler thread last reported, read by the caller's thread
+struct Portfolio::Tally : public Progress {
+    std::atomic<long> nodes, backtracks;
+    std::atomic<int> depth;
+    Tally(long msecs) : Progress(msecs), nodes(0), backtracks(0), depth(0) {}
+    void progress(long n, long b, int dep) override {
+        nodes.store(n, std::memory_order_relaxed);
+        backtracks.store(b, std::memory_order_relaxed);
+        depth.store(dep, std::memory_order_relaxed);
+    }
+};
+
+Portfolio::Portfolio(Grid &thegrid, Dict &thedict, int n)
+    : g(thegrid), d(thedict), domaindict(0), nthreads(n), winner(-1),
+      learning(false) {
+    if (nthreads <= 0)
+        nthreads = std::thread::hardware_concurrency();
+    if (nthreads <= 0)
+        nthreads = 1;
+}
+
+// Half the compilers take the most constrained cell next, the others
+// flood; half of each propagate. Half jump back by conflict sets
+// instead of the smart backtracker's guesses: the first, which also
+// restarts with a new seed whenever a run takes too long, and one that
+// does not propagate and so can learn nogoods. So the first compiler,
+// the only one on one core, never skips a fill. Each of these finds
+// fills the others miss. The PrefixWalker does not work yet.
+void Portfolio::run(int i, Grid &mine, std::atomic<bool> &done, std::atomic<int> &first) {
+    try {
+        if (domaindict)
+            mine.attachdomains(*domaindict);
+        FloodWalker fw(mine);
+        MRVWalker mw(mine, d);
+        ConflictBacktracker cbt(mine);
+        NogoodStore nogoods;
+        if (learns(i))
+            cbt.setnogoods(&nogoods);
+        SmartBacktracker sbt(mine);
+        Compiler c(mine, flood(i) ? (Walker &)fw : (Walker &)mw,
+                   backjumps(i) ? (Backtracker &)cbt : (Backtracker &)sbt, d);
+        c.propagation = propagates(i);
+        Compiler::Result r;
+        if (restarts(i)) {
+            RestartingCompiler rc(c);
+            rc.setseed(seeds[i]);
+            r = rc.compile(Compiler::Clock::time_point::max(), &done, tallies[i]);
+        } else {
+            c.setseed(seeds[i]);
+            r = c.compile(Compiler::Clock::time_point::max(), &done, tallies[i]);
+        }
+        tallies[i]->progress(r.nodes, r.backtracks, 0);
+        int none = -1;
+        if (r.outcome == Compiler::solved && first.compare_exchange_strong(none, i))
+            done = true;
+        // nobody else can find a fill either
+        if (r.outcome == Compiler::unsat)
+            done = true;
+    } catch (error &e) {
+        // the grid is the same for everybody, so is the error
+        if (!done.exchange(true))
+            failure = e.what();
+    } catch (...) {
+        // out of memory, most likely; an escaping exception would end
+        // the program
+        if (!done.exchange(true))
+            failure = "Compiler thread failed";
+    }
+    mine.detachdomains();
+}
+
+bool Portfolio::compile() {
+    Compiler::Result r = compile(Compiler::Clock::time_point::max());
+    return r.outcome == Compiler::solved;
+}
+
+// The compilers only watch done; this thread sets it at the deadline
+// or on a cancel, and adds up their progress while it waits.
+Compiler::Result Portfolio::compile(Compiler::Clock::time_point deadline,
+                                    std::atomic<bool> *cancelflag, Progress *progress) {
+    typedef Compiler::Clock Clock;
+    // how often this thread wakes up
+    const std::chrono::milliseconds tick(5);
+    winner = -1;
+    failure.clear();
+    seeds.resize(nthreads);
+    for (int i = 0; i < nthreads; i++)
+        seeds[i] = rng.next();
+
+    // copy before starting, g is not touched while the threads run
+    std::vector<Grid *> grids;
+    // the compilers report twice as often, so each sum is fresh
+    long interval = progress ? std::max(1L, progress->interval / 2) : 100;
+    for (int i = 0; i < nthreads; i++) {
+        grids.push_back(new Grid(g));
+        tallies.push_back(new Tally(interval));
+    }
+
+    std::atomic<bool> done(false);
+    std::atomic<int> first(-1);
+    std::atomic<int> running(nthreads);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < nthreads; i++)
+        threads.push_back(std::thread([this, i, &grids, &done, &first, &running] {
+            run(i, *grids[i], done, first);
+            running--;
+        }));
+
+    Compiler::Result r;
+    r.outcome = Compiler::unsat;
+    Clock::time_point report = Clock::now();
+    if (progress)
+        report += std::chrono::milliseconds(progress->interval);
+    while (running > 0) {
+        std::this_thread::sleep_for(tick);
+        Clock::time_point now = Clock::now();
+        if (done)
+            continue;
+        if (now >= deadline) {
+            if (!done.exchange(true))
+                r.outcome = Compiler::timeout;
+        } else if (cancelflag && *cancelflag) {
+            if (!done.exchange(true))
+                r.outcome = Compiler::cancelled;
+        } else if (progress && now >= report) {
+            long nodes = 0, backtracks = 0;
+            int depth = 0;
+            for (int i = 0; i < nthreads; i++) {
+                nodes += tallies[i]->nodes.load(std::memory_order_relaxed);
+                backtracks += tallies[i]->backtracks.load(std::memory_order_relaxed);
+                depth = std::max(depth, tallies[i]->depth.load(std::memory_order_relaxed));
+            }
+            progress->progress(nodes, backtracks, depth);
+            report = now + std::chrono::milliseconds(progress->interval);
+        }
+    }
+    for (int i = 0; i < nthreads; i++)
+        threads[i].join();
+
+    winner = first;
+    if (winner >= 0) {
+        g.copyfill(*grids[winner]);
+        r.outcome = Compiler::solved;
+    }
+    // otherwise the first compiler, which runs until it is stopped,
+    // has shown there is no fill
+    r.nodes = 0;
+    r.backtracks = 0;
+    for (int i = 0; i < nthreads; i++) {
+        r.nodes += tallies[i]->nodes;
+        r.backtracks += tallies[i]->backtracks;
+        delete grids[i];
+        delete tallies[i];
+    }
+    tallies.clear();
+    if (winner < 0 && !failure.empty())
+        throw error(failure);
+    return r;
+}
@@ -0,0 +1,97 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+
+#ifndef CWC_PORTFOLIO_HH
+#define CWC_PORTFOLIO_HH
+
+#include <vector>
+#include <string>
+#include <stdint.h>
+#include "grid.hh"
+#include "dict.hh"
+#include "random.hh"
+#include "cwc.hh"
+
+class BitDict;
+
+/**
+ * Runs several independent compilers on copies of a grid, each in its
+ * own thread with its own seed, walker and backtracker, and keeps the fill of
+ * the first one to succeed. The others are then cancelled.
+ *
+ * The dictionary is shared by all threads, so it must answer queries
+ * without changing itself: a BitDict after build(), a MappedDict or a
+ * BtreeDict, not a LetterDict or a CachedDict.
+ */
+
+class Portfolio {
+    Grid &g;
+    Dict &d;
+    BitDict *domaindict;
+    int nthreads;
+    Random rng;
+    std::vector<uint64_t> seeds;
+    int winner;
+    std::string failure;
+    struct Tally;
+    std::vector<Tally *> tallies;
+
+    void run(int i, Grid &mine, std::atomic<bool> &done, std::atomic<int> &first);
+public:
+    // nthreads 0 means one per core
+    Portfolio(Grid &thegrid, Dict &thedict, int nthreads = 0);
+    // give every copy slot domains over bd, see Grid::attachdomains
+    void usedomains(BitDict &bd) { domaindict = &bd; }
+    void setseed(uint64_t seed) { rng.setseed(seed); }
+    int numthreads() { return nthreads; }
+    // let the compiler that jumps back without propagating learn
+    // nogoods; off by default, since on most grids they cost more
+    // letters than they save
+    bool learning;
+    bool compile();
+    /**
+     * compile() that gives up at deadline, or once *cancelflag becomes
+     * true. progress is called on this thread with the letters and
+     * dead ends of all compilers and the most cells any of them has
+     * filled. Unless solved, the grid is left as it was.
+     */
+    Compiler::Result compile(Compiler::Clock::time_point deadline,
+                             std::atomic<bool> *cancelflag = 0, Progress *progress = 0);
+
+    // the compiler that filled the grid, -1 if none did, and what it
+    // used; a single Compiler, or RestartingCompiler, with these
+    // repeats its fill
+    int getwinner() { return winner; }
+    uint64_t getseed(int i) { return seeds[i]; }
+    bool flood(int i) { return i % 2 == 1; }
+    bool backjumps(int i) { return i % 4 == 0 || i % 4 == 3; }
+    bool propagates(int i) { return i % 4 < 2; }
+    bool restarts(int i) { return i % 4 == 0; }
+    bool learns(int i) { return learning && backjumps(i) && !propagates(i); }
+    std::string strategy(int i) {
+        return std::string(flood(i) ? "flood" : "mrv") + (backjumps(i) ? "/cbj" : "/smart")
+            + (propagates(i) ? "/fc" : "") + (restarts(i) ? "/restarts" : "")
+            + (learns(i) ? "/nogoods" : "");
+    }
+};
+
+#endif // CWC_PORTFOLIO_HH
@@ -0,0 +1,121 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+
+#include "postings.hh"
+
+//////////////////////////////////////////////////////////////////////
+// posting iterator
+
+PostingIterator::PostingIterator(const uint8_t *d, const PostingSkip *s, int n)
+    : data(d), p(0), skips(s), count(n), block(0), inblock(0), value(0) {
+    if (count > 0)
+        enterblock(0);
+}
+
+void PostingIterator::enterblock(int b) {
+    block = b;
+    inblock = 0;
+    value = skips[b].first;
+    p = data + skips[b].offset;
+}
+
+void PostingIterator::next() {
+    if (++inblock == blocksize) {
+        if (block * blocksize + inblock < count)
+            enterblock(block + 1);
+        return;
+    }
+    if (atend())
+        return;
+    int delta = 0, shift = 0;
+    uint8_t byte;
+    do {
+        byte = *p++;
+        delta |= (byte & 0x7f) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+    value += delta;
+}
+
+void PostingIterator::skipto(int target) {
+    if (atend() || value >= target)
+        return;
+    // gallop over the skip entries to find the last block starting at
+    // or before target, then binary search the last step.
+    int nblocks = (count + blocksize - 1) / blocksize;
+    int lo = block, hi = block + 1, step = 1;
+    while (hi < nblocks && skips[hi].first <= target) {
+        lo = hi;
+        hi += step;
+        step *= 2;
+    }
+    if (hi > nblocks)
+        hi = nblocks;
+    while (hi - lo > 1) {
+        int mid = (lo + hi) / 2;
+        if (skips[mid].first <= target)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    if (lo != block)
+        enterblock(lo);
+    while (!atend() && value < target)
+        next();
+}
+
+//////////////////////////////////////////////////////////////////////
+// posting list
+
+PostingList::PostingList() : count(0), last(0) {
+}
+
+void PostingList::add(int wordi) {
+    if (count % PostingIterator::blocksize == 0) {
+        PostingSkip s = { wordi, uint32_t(data.size()) };
+        skips.push_back(s);
+    } else {
+        unsigned int delta = wordi - last;
+        while (delta >= 0x80) {
+            data.push_back(uint8_t(delta | 0x80));
+            delta >>= 7;
+        }
+        data.push_back(uint8_t(delta));
+    }
+    last = wordi;
+    count++;
+}
+
+void PostingList::compact() {
+    data.shrink_to_fit();
+    skips.shrink_to_fit();
+}
+
+size_t PostingList::bytes() const {
+    return data.size() + skips.size() * sizeof(PostingSkip);
+}
+
+PostingIterator PostingList::begin() const {
+    if (count == 0)
+        return PostingIterator();
+    return PostingIterator(data.data(), skips.data(), count);
+}
@@ -0,0 +1,115 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+
+#ifndef CWC_POSTINGS_HH
+#define CWC_POSTINGS_HH
+
+#include <vector>
+#include <algorithm>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Sorted list of word numbers, stored in blocks of delta coded
+ * varints. Every block has a skip entry with its first value and the
+ * byte offset of the rest of the block, so the list can be walked
+ * without decoding blocks that cannot contain a match.
+ */
+
+struct PostingSkip {
+    int32_t first;
+    uint32_t offset;
+};
+
+class PostingIterator {
+    const uint8_t *data, *p;
+    const PostingSkip *skips;
+    int count, block, inblock, value;
+    void enterblock(int b);
+public:
+    static const int blocksize = 64;
+    PostingIterator() : data(0), p(0), skips(0), count(0), block(0), inblock(0), value(0) {}
+    PostingIterator(const uint8_t *data, const PostingSkip *skips, int count);
+    int size() const { return count; }
+    bool atend() const { return block * blocksize + inblock >= count; }
+    int operator*() const { return value; }
+    void next();
+    // advance to the first value >= target
+    void skipto(int target);
+};
+
+/**
+ * Calls f(wordi) for every word number present in all of the n lists,
+ * in increasing order, until f returns false. The shortest list drives
+ * the intersection and the longer ones are only probed with skipto(),
+ * so the iterators are reordered by size.
+ */
+template<class F>
+void intersect(PostingIterator *it, int n, F f) {
+    std::sort(it, it + n, [](const PostingIterator &a, const PostingIterator &b) {
+        return a.size() < b.size();
+    });
+    for (int i = 0; i < n; i++)
+        if (it[i].atend())
+            return;
+
+    while (1) {
+        int target = *it[0];
+        int i;
+        for (i = 1; i < n; i++) {
+            it[i].skipto(target);
+            if (it[i].atend())
+                return;
+            if (*it[i] != target)
+                break;
+        }
+        if (i < n) {
+            // it[i] overshot: move the driver up to it
+            it[0].skipto(*it[i]);
+            if (it[0].atend())
+                return;
+            continue;
+        }
+        if (!f(target))
+            return;
+        it[0].next();
+        if (it[0].atend())
+            return;
+    }
+}
+
+class PostingList {
+    std::vector<uint8_t> data;
+    std::vector<PostingSkip> skips;
+    int count, last;
+public:
+    PostingList();
+    void add(int wordi); // values must be added in increasing order
+    void compact();
+    int size() const { return count; }
+    size_t bytes() const;
+    PostingIterator begin() const;
+    const std::vector<uint8_t> &rawdata() const { return data; }
+    const std::vector<PostingSkip> &rawskips() const { return skips; }
+};
+
+#endif // CWC_POSTINGS_HH
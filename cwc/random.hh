@@ -0,0 +1,45 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+
+#ifndef CWC_RANDOM_HH
+#define CWC_RANDOM_HH
+
+#include <stdint.h>
+
+/**
+ * Small seedable random number generator (splitmix64). Each Compiler
+ * owns one, so solvers in different threads do not share state, and a
+ * run can be repeated exactly by giving it the same seed.
+ */
+
+class Random {
+    uint64_t seed, state;
+public:
+    Random(uint64_t theseed = 1) { setseed(theseed); }
+    void setseed(uint64_t s) { seed = state = s; }
+    uint64_t getseed() { return seed; }
+    uint64_t next();
+    // uniform in [0, n)
+    int below(int n) { return int(((next() >> 32) * uint64_t(n)) >> 32); }
+};
+
+#endif // CWC_RANDOM_HH
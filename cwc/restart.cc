@@ -0,0 +1,114 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+
+#include <chrono>
+#include <algorithm>
+#include "restart.hh"
+#include "cwc.hh"
+
+//////////////////////////////////////////////////////////////////////
+// class restarting_compiler
+
+RestartingCompiler::RestartingCompiler(Compiler &thecompiler)
+    : c(thecompiler), restarts(0), nodes(0), backtracks(0), schedule(luby), unit(100),
+      growth(1.5), keeppreferred(false), keeplearned(true), timelimit(0) {
+}
+
+long RestartingCompiler::lubyterm(long i) {
+    // i lies in the block that ends at 2^k - 1, with that block's term
+    // 2^(k-1) last; the rest of the block repeats the sequence
+    for (;;) {
+        long k = 1;
+        while ((1L << k) - 1 < i)
+            k++;
+        if (i == (1L << k) - 1)
+            return 1L << (k - 1);
+        i -= (1L << (k - 1)) - 1;
+    }
+}
+
+bool RestartingCompiler::compile() {
+    Compiler::Clock::time_point deadline = Compiler::Clock::time_point::max();
+    if (timelimit > 0)
+        deadline = Compiler::Clock::now() + std::chrono::milliseconds(timelimit);
+    return compile(deadline).outcome == Compiler::solved;
+}
+
+Compiler::Result RestartingCompiler::compile(Compiler::Clock::time_point deadline,
+                                             std::atomic<bool> *cancelflag, Progress *progress) {
+    typedef Compiler::Clock Clock;
+    // how often a run looks at the clock
+    const long slice = 4096;
+    std::atomic<bool> *saved = c.getcancel();
+    if (cancelflag)
+        c.setcancel(cancelflag);
+    Clock::time_point report = Clock::now();
+    if (progress)
+        report += std::chrono::milliseconds(progress->interval);
+
+    Compiler::Result r;
+    restarts = 0;
+    nodes = 0;
+    backtracks = 0;
+    double budget = unit;
+    for (long run = 1; ; run++) {
+        long limit = schedule == luby ? unit * lubyterm(run) : long(budget);
+        c.setseed(rng.next());
+        c.start();
+        Compiler::Status st = Compiler::suspended;
+        bool expired = false;
+        while (st == Compiler::suspended && c.getnodes() < limit && !expired) {
+            st = c.resume(std::min(slice, limit - c.getnodes()));
+            Clock::time_point now = Clock::now();
+            expired = now >= deadline;
+            if (progress && now >= report) {
+                progress->progress(nodes + c.getnodes(), backtracks + c.getbacktracks(),
+                                   c.getdepth());
+                report = now + std::chrono::milliseconds(progress->interval);
+            }
+        }
+        nodes += c.getnodes();
+        backtracks += c.getbacktracks();
+        if (st == Compiler::filled) {
+            r.outcome = Compiler::solved;
+            break;
+        }
+        // a cancelled run also ends exhausted, with cells still filled
+        if (expired || c.stopping()) {
+            r.outcome = expired ? Compiler::timeout : Compiler::cancelled;
+            c.rewind();
+            break;
+        }
+        if (st == Compiler::exhausted && c.complete()) {
+            r.outcome = Compiler::unsat;
+            c.rewind();
+            break;
+        }
+        c.rewind(keeppreferred, keeplearned);
+        restarts++;
+        budget *= growth;
+    }
+    r.nodes = nodes;
+    r.backtracks = backtracks;
+    c.setcancel(saved);
+    return r;
+}
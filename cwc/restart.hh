@@ -0,0 +1,80 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+
+#ifndef CWC_RESTART_HH
+#define CWC_RESTART_HH
+
+#include <stdint.h>
+#include "random.hh"
+#include "cwc.hh"
+
+/**
+ * Runs a Compiler again and again with a new seed each time, giving
+ * each run a budget of letters to try before it is abandoned. One
+ * unlucky first letter can cost a run minutes where another seed fills
+ * the grid in milliseconds, so many short runs have far shorter worst
+ * cases than one long one.
+ *
+ * The budgets follow the Luby sequence 1 1 2 1 1 2 4 1 1 2 ..., or
+ * grow geometrically, in units of unit letters. If the compiler is
+ * complete (see Compiler::complete()), a run that exhausts its tree
+ * proves there is no fill. Otherwise that run is restarted like any
+ * other, so a grid with no fill keeps it going until the time limit
+ * or a cancel.
+ */
+
+class RestartingCompiler {
+    Compiler &c;
+    Random rng;
+    int restarts;
+    long nodes, backtracks;
+public:
+    enum Schedule { luby, geometric };
+
+    RestartingCompiler(Compiler &thecompiler);
+    Schedule schedule;
+    // letters in the shortest run, and the growth of geometric budgets
+    long unit;
+    double growth;
+    // let the cells prefer the letters they had when the last run was
+    // abandoned, and the backtracker keep its nogoods
+    bool keeppreferred, keeplearned;
+    // give up after this many milliseconds, 0 for never
+    long timelimit;
+
+    void setseed(uint64_t seed) { rng.setseed(seed); }
+    // false if there is no fill, or none was found in time or before a
+    // cancel; the grid is then left empty
+    bool compile();
+    // as Compiler::compile() with a deadline, which takes the place of
+    // timelimit; unsat only from a complete compiler
+    Compiler::Result compile(Compiler::Clock::time_point deadline,
+                             std::atomic<bool> *cancelflag = 0, Progress *progress = 0);
+    int getrestarts() { return restarts; }
+    // letters tried and dead ends met over all runs
+    long getnodes() { return nodes; }
+    long getbacktracks() { return backtracks; }
+    // the i-th term of the Luby sequence, from 1
+    static long lubyterm(long i);
+};
+
+#endif // CWC_RESTART_HH
@@ -0,0 +1,177 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+
+
+#include <iostream>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "scandict.hh"
+
+//////////////////////////////////////////////////////////////////////
+// compare kernel
+
+// bit i is set if a[i] == b[i], for 32 bytes
+static inline uint32_t eqmask(const uint8_t *a, const uint8_t *b) {
+#if defined(__AVX2__)
+    __m256i va = _mm256_loadu_si256((const __m256i *)a);
+    __m256i vb = _mm256_loadu_si256((const __m256i *)b);
+    return uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(va, vb)));
+#elif defined(__SSE2__)
+    __m128i lo = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)a),
+                                _mm_loadu_si128((const __m128i *)b));
+    __m128i hi = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(a + 16)),
+                                _mm_loadu_si128((const __m128i *)(b + 16)));
+    return uint32_t(_mm_movemask_epi8(lo)) | uint32_t(_mm_movemask_epi8(hi)) << 16;
+#else
+    uint32_t m = 0;
+    for (int i = 0; i < 32; i++)
+        if (a[i] == b[i]) m |= uint32_t(1) << i;
+    return m;
+#endif
+}
+
+//////////////////////////////////////////////////////////////////////
+// scandict
+
+ScanDict::ScanDict() {
+}
+
+void ScanDict::addword(Symbol *st, int /*wordi*/) {
+    int wlen = wordlen(st);
+    if (wlen >= MAXWORDLEN)
+        return;
+    Bucket &b = buckets[wlen];
+    if (b.stride == 0) {
+        b.stride = 4;
+        while (b.stride < wlen) b.stride *= 2;
+        for (int i = 0; i < wlen; i++) b.all[i] = 0;
+    }
+    size_t at = size_t(b.nwords) * b.stride;
+    b.rows.resize((at + b.stride + 31) & ~size_t(31), 0);
+    for (int i = 0; i < wlen; i++) {
+        b.rows[at + i] = st[i].symbvalue();
+        b.all[i] |= st[i].getsymbolset();
+    }
+    b.nwords++;
+}
+
+// calls f(row) for every row matching the fixed letters of s, until f
+// returns false. Padding rows hold symbol 0 and never match a letter.
+template<class F>
+void ScanDict::scan(Bucket &b, Symbol *s, int len, F f) {
+    int stride = b.stride;
+    uint8_t pat[32];
+    uint32_t need = 0;
+    for (int i = 0; i < 32; i++) pat[i] = 0;
+    for (int i = 0; i < len; i++) {
+        if (s[i] == Symbol::empty) continue;
+        for (int r = i; r < 32; r += stride) {
+            pat[r] = s[i].symbvalue();
+            need |= uint32_t(1) << r;
+        }
+    }
+    // a row matches if its stride bits of miss are all clear. low and
+    // high hold the lowest and highest bit of every row; the zero
+    // element test (miss - low) & ~miss & high is exact in telling
+    // whether any row of the block matches.
+    uint32_t rowbits = stride == 32 ? ~uint32_t(0) : (uint32_t(1) << stride) - 1;
+    uint32_t low = 0, high = 0;
+    for (int r = 0; r < 32; r += stride) {
+        low |= uint32_t(1) << r;
+        high |= uint32_t(1) << (r + stride - 1);
+    }
+    const uint8_t *p = b.rows.data();
+    const uint8_t *end = p + size_t(b.nwords) * stride;
+    for (; p < end; p += 32) {
+        uint32_t miss = ~eqmask(p, pat) & need;
+        if (((miss - low) & ~miss & high) == 0)
+            continue;
+        for (int r = 0; r < 32; r += stride) {
+            if (((miss >> r) & rowbits) == 0 && p + r < end)
+                if (!f(p + r))
+                    return;
+        }
+    }
+}
+
+SymbolSet ScanDict::findpossible(Symbol *s, int len, int pos) {
+    if (len == 1) return wl->allalpha;
+    if (len >= MAXWORDLEN) return 0;
+
+    Bucket &b = buckets[len];
+    if (b.nwords == 0) return 0;
+
+    bool any = false;
+    for (int i = 0; i < len && !any; i++)
+        any = s[i] != Symbol::empty;
+    if (!any) return b.all[pos];
+
+    SymbolSet ss = 0;
+    SymbolSet full = b.all[pos];
+    scan(b, s, len, [&](const uint8_t *row) {
+        ss |= SymbolSet(1) << row[pos];
+        return ss != full;
+    });
+    return ss;
+}
+
+int ScanDict::findslot(Symbol *s, int len, SymbolSet *sets) {
+    if (len == 1 || len >= MAXWORDLEN) return Dict::findslot(s, len, sets);
+
+    for (int i = 0; i < len; i++) sets[i] = 0;
+    Bucket &b = buckets[len];
+    if (b.nwords == 0) return 0;
+
+    int n = 0;
+    scan(b, s, len, [&](const uint8_t *row) {
+        for (int i = 0; i < len; i++)
+            sets[i] |= SymbolSet(1) << row[i];
+        n++;
+        return true;
+    });
+    return n;
+}
+
+void ScanDict::load(const std::string &fn) {
+    std::cout << "Loading wordlist and building dictionary... " << std::flush;
+
+    wl = new WordList();
+    wl->load(fn);
+
+    int nwords = wl->numwords();
+    for (int i=0; i<nwords; i++)
+        addword((*wl)[i], i);
+
+    std::cout << "ok" << std::endl;
+}
+
+size_t ScanDict::memoryusage() {
+    size_t n = 0;
+    for (int len = 0; len < MAXWORDLEN; len++)
+        n += buckets[len].rows.capacity();
+    return n;
+}
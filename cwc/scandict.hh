@@ -0,0 +1,62 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+
+#ifndef CWC_SCANDICT_HH
+#define CWC_SCANDICT_HH
+
+#include <vector>
+#include <stdint.h>
+#include "symbol.hh"
+#include "dict.hh"
+#include "wordlist.hh"
+
+/**
+ * Dictionary without an index: the words of each length are stored as
+ * rows of symbol values, padded to a stride of 4, 8, 16 or 32 bytes,
+ * and a query compares the pattern against 32 bytes of rows at a time.
+ * For the short lengths, where there are few words and most of them
+ * match, this beats walking posting lists.
+ */
+
+class ScanDict : public Dict {
+    struct Bucket {
+        Bucket() : stride(0), nwords(0) {}
+        int stride;
+        int nwords;
+        std::vector<uint8_t> rows; // nwords * stride, padded to 32 bytes
+        SymbolSet all[MAXWORDLEN];
+    };
+    Bucket buckets[MAXWORDLEN];
+
+    template<class F> void scan(Bucket &b, Symbol *s, int len, F f);
+public:
+    WordList *wl = nullptr;
+    ScanDict();
+    void addword(Symbol *st, int wordi);
+    int numwords(int len) { return buckets[len].nwords; }
+    SymbolSet findpossible(Symbol *s, int len, int pos);
+    int findslot(Symbol *s, int len, SymbolSet *sets);
+    void load(const std::string &fn);
+    size_t memoryusage();
+};
+
+#endif // CWC_SCANDICT_HH
@@ -0,0 +1,133 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+
+
+#include <chrono>
+#include <vector>
+
+#include "selectdict.hh"
+#include "random.hh"
+#include "wordlist.hh"
+
+//////////////////////////////////////////////////////////////////////
+// selectdict
+
+SelectDict::SelectDict() {
+    for (int len = 0; len < MAXWORDLEN; len++) {
+        choice[len] = 0;
+        chosen[len] = -1;
+    }
+}
+
+void SelectDict::addengine(Dict &d, const char *name) {
+    engines.push_back(&d);
+    names.push_back(name);
+    for (int len = 0; len < MAXWORDLEN; len++)
+        if (choice[len] == 0) choice[len] = &d;
+}
+
+// where the answers of the timed queries go, so they are not optimized out
+static volatile SymbolSet sink;
+
+void SelectDict::calibrate(WordList &wl, int samples) {
+    if (engines.empty()) throw error("No engines to select from");
+
+    std::vector<int> bylen[MAXWORDLEN];
+    int nwords = wl.numwords();
+    for (int i = 0; i < nwords; i++) {
+        int len = wordlen(wl[i]);
+        if (len < MAXWORDLEN) bylen[len].push_back(i);
+    }
+
+    // queries like the compiler asks: a word with one to three of its
+    // letters kept, asking for one of the others
+    Random rng(12345);
+    for (int len = 2; len < MAXWORDLEN; len++) {
+        if (bylen[len].empty()) continue;
+        int n = samples;
+        std::vector<Symbol> pats(n * len);
+        std::vector<int> ask(n);
+        for (int q = 0; q < n; q++) {
+            Symbol *st = wl[bylen[len][q * bylen[len].size() / n]];
+            Symbol *pat = &pats[q * len];
+            for (int i = 0; i < len; i++) pat[i] = Symbol::empty;
+            int nfixed = 1 + q % 3;
+            if (nfixed >= len) nfixed = len - 1;
+            for (int k = 0; k < nfixed; k++) {
+                int i = rng.below(len);
+                pat[i] = st[i];
+            }
+            ask[q] = 0;
+            while (ask[q] < len - 1 && !(pat[ask[q]] == Symbol::empty)) ask[q]++;
+        }
+
+        double best = 0;
+        for (unsigned e = 0; e < engines.size(); e++) {
+            Dict &d = *engines[e];
+            SymbolSet seen = 0;
+            double t = 0;
+            for (int round = 0; round < 3; round++) {
+                std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+                for (int q = 0; q < n; q++)
+                    seen |= d.findpossible(&pats[q * len], len, ask[q]);
+                double dt = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+                if (round == 0 || dt < t) t = dt; // the first round also warms up
+            }
+            sink = seen;
+            if (chosen[len] < 0 || t < best) {
+                best = t;
+                chosen[len] = e;
+                choice[len] = &d;
+            }
+        }
+    }
+}
+
+void SelectDict::load(const std::string &fn) {
+    for (unsigned e = 0; e < engines.size(); e++)
+        engines[e]->load(fn);
+}
+
+SymbolSet SelectDict::findpossible(Symbol *s, int len, int pos) {
+    if (len >= MAXWORDLEN) return 0;
+    return choice[len]->findpossible(s, len, pos);
+}
+
+int SelectDict::findslot(Symbol *s, int len, SymbolSet *sets) {
+    if (len >= MAXWORDLEN) return Dict::findslot(s, len, sets);
+    return choice[len]->findslot(s, len, sets);
+}
+
+size_t SelectDict::memoryusage() {
+    size_t n = 0;
+    for (unsigned e = 0; e < engines.size(); e++)
+        n += engines[e]->memoryusage();
+    return n;
+}
+
+void SelectDict::report(std::ostream &os) {
+    os << "Engine per length:";
+    for (int len = 0; len < MAXWORDLEN; len++)
+        if (chosen[len] >= 0)
+            os << ' ' << len << '=' << names[chosen[len]];
+    os << std::endl;
+}
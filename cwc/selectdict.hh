@@ -0,0 +1,57 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+
+#ifndef CWC_SELECTDICT_HH
+#define CWC_SELECTDICT_HH
+
+#include <vector>
+#include <iostream>
+#include "symbol.hh"
+#include "dict.hh"
+
+class WordList;
+
+/**
+ * Dict forwarding each query to one of several engines holding the
+ * same words, chosen per word length. calibrate() times every engine
+ * on queries made from the word list and keeps the fastest for each
+ * length. The engines are not owned.
+ */
+
+class SelectDict : public Dict {
+    std::vector<Dict *> engines;
+    std::vector<const char *> names;
+    Dict *choice[MAXWORDLEN];
+    int chosen[MAXWORDLEN];
+public:
+    SelectDict();
+    void addengine(Dict &d, const char *name);
+    void calibrate(WordList &wl, int samples = 256);
+    Dict &engine(int len) { return *choice[len]; }
+    void load(const std::string &fn);
+    SymbolSet findpossible(Symbol *s, int len, int pos);
+    int findslot(Symbol *s, int len, SymbolSet *sets);
+    size_t memoryusage();
+    void report(std::ostream &os);
+};
+
+#endif // CWC_SELECTDICT_HH
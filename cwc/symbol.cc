@@ -23,100 +23,86 @@
 
 #include "symbol.hh"
 
-#include <stdlib.h>
-
 //////////////////////////////////////////////////////////////////////
 // class symbol
 
-char Symbol::alphabet[32];
-Symbol Symbol::alphindex[256];
-
-int Symbol::symballoc = 0;
-Symbol Symbol::outside;
-Symbol Symbol::none;
-Symbol Symbol::empty;
+const Symbol Symbol::none(0);
+const Symbol Symbol::empty(1);
+const Symbol Symbol::outside(2);
 
 Symbol Symbol::symbolbit(SymbolSet ss) {
-    Symbol s;
-    for (SymbolSet i=1,n=0; i; i<<=1,n++) {
-        if (ss&i)
-            s.symb = n;
-    }
-    return s;
+    if (ss == 0) return Symbol();
+    return Symbol(char(8 * sizeof(SymbolSet) - 1 - __builtin_clzl(ss)));
 }
 
-Symbol Symbol::alloc(char ch) {
-    Symbol s;
-    if (symballoc >= 32) {
-        for (int i=0; i<32;i++) std::cout << alphabet[i];
-        std::cout << std::endl;
-        std::cout << ch << ' ' << int(ch) << std::endl;
-        throw error("Too many symbols");
+//////////////////////////////////////////////////////////////////////
+// class alphabet
+
+Alphabet::Alphabet(const std::string &letters) : nletters(0) {
+    for (int i = 0; i < 128; i++)
+        chars[i] = UNDEF;
+    chars[0] = '/';
+    chars[1] = '+';
+    chars[2] = ' ';
+    for (size_t i = 0; i < letters.size(); i++) {
+        char ch = letters[i];
+        bool seen = false;
+        for (int v = 0; v < 3 + nletters; v++)
+            if (chars[v] == ch) seen = true;
+        if (seen) continue;
+        if (3 + nletters >= 32)
+            throw error("Too many symbols");
+        chars[3 + nletters++] = ch;
     }
+    for (int i = 0; i < 256; i++)
+        index[i] = Symbol();
+    for (int v = 0; v < 3 + nletters; v++)
+        index[(unsigned char)chars[v]] = Symbol(char(v));
+}
 
-    s.symb = symballoc;
-    symballoc++;
-    alphabet[(int)s.symb] = ch;
-    alphindex[(unsigned char)ch].symb = s.symb;
-    return s;
+const Alphabet &Alphabet::latin() {
+    static const Alphabet a("abcdefghijklmnopqrstuvwxyz");
+    return a;
 }
 
-void Symbol::buildindex() {
-    for (int i=0;i<32;i++)
-        alphabet[i] = UNDEF;
-    for (int i=0;i<256;i++)
-        alphindex[i].symb = UNDEF;
-    symballoc = 0;
-    none = Symbol::alloc('/');
-    empty = Symbol::alloc('+');
-    outside = Symbol::alloc(' ');
+SymbolSet Alphabet::letters() const {
+    return ((SymbolSet(1) << nletters) - 1) << 3;
 }
 
-Symbol::Symbol(char ch) {
-    symb = alphindex[(unsigned char)ch].symb;
-    if (symb == UNDEF)
-        *this = Symbol::alloc(ch);
+std::string Alphabet::word(const Symbol *st) const {
+    return word(st, wordlen(st));
 }
 
-SymbolSet pickbit(SymbolSet &ss) {
-    int a[32], n = 0;
-    for (int i=1; i; i<<=1) {
-        if (ss & i)
-            a[n++] = i;
-    }
-    if (n==0) return 0;
-    SymbolSet bit = a[rand()%n];
-    ss &= ~bit;
-    return bit;
+std::string Alphabet::word(const Symbol *st, int len) const {
+    std::string w(len, ' ');
+    for (int i = 0; i < len; i++)
+        w[i] = letter(st[i]);
+    return w;
 }
 
-int wordlen(Symbol *st) {
-    int n = 0;
-    while (st[n] != Symbol::outside) n++;
-    return n;
+std::string Alphabet::letters(SymbolSet ss) const {
+    std::string l;
+    for (int v = 0; ss; v++, ss >>= 1)
+        if (ss & 1)
+            l += chars[v];
+    return l;
 }
 
-std::ostream &operator <<(std::ostream &os, Symbol *s) {
-    while (*s != Symbol::outside) {
-        os << *s;
-        s++;
-    }
-    return os;
+//////////////////////////////////////////////////////////////////////
+
+SymbolSet pickbit(SymbolSet &ss, Random &rng) {
+    if (ss == 0) return 0;
+    SymbolSet bit = selectbit(ss, rng.below(__builtin_popcountl(ss)));
+    ss &= ~bit;
+    return bit;
 }
 
-int numones(SymbolSet ss) {
+int wordlen(const Symbol *st) {
     int n = 0;
-    for (int i=1; i; i <<= 1) {
-        if (ss&i)
-            n++;
-    }
+    while (st[n] != Symbol::outside) n++;
     return n;
 }
 
-int Symbol::numalpha() {
-    int n = 0;
-    for (int i=0; i<32; i++)
-        if (isalpha(alphabet[i]))
-            n++;
-    return n;
+int numones(SymbolSet ss) {
+    return __builtin_popcountl(ss);
 }
@@ -22,37 +22,42 @@
 #ifndef CWC_SYMBOL_HH
 #define CWC_SYMBOL_HH
 
+#include <string>
 #include "main.hh"
+#include "random.hh"
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
 
 typedef unsigned long SymbolSet;
 
 #define UNDEF 0x7f
 
+/**
+ * A symbol is the index of a character in an Alphabet. The values
+ * 0, 1 and 2 are the special symbols none, empty and outside in every
+ * alphabet; letters follow from 3.
+ */
+
 class Symbol {
     char symb;
-    static Symbol alphindex[256];
-    static char searchchar(char);
-    static int symballoc;
+    explicit constexpr Symbol(char v) : symb(v) {}
+    friend class Alphabet;
 public:
-    static char alphabet[32];
-    static Symbol outside, empty, none;
-    static Symbol alloc(char ch = UNDEF);
+    static const Symbol outside, empty, none;
     static Symbol symbolbit(SymbolSet); // named constructor
-    //  static symbol special();
 
-    Symbol() : symb(UNDEF) {}
-    Symbol(char ch);
+    constexpr Symbol() : symb(UNDEF) {}
 
-    inline SymbolSet getsymbolset();
-    inline operator char();
+    inline SymbolSet getsymbolset() const;
     inline bool operator == (Symbol const &s) const;
+    inline bool operator != (Symbol const &s) const;
 
-    static void buildindex();
-    int symbvalue() { return int(symb); }
-    static int numalpha();
+    int symbvalue() const { return int(symb); }
 };
 
-SymbolSet Symbol::getsymbolset() {
+SymbolSet Symbol::getsymbolset() const {
     return 1 << symb;
 }
 
@@ -60,20 +65,57 @@ bool Symbol::operator==(Symbol const &s) const {
     return symb == s.symb;
 }
 
-Symbol::operator char() {
-    if (symb == UNDEF) throw error("action on undefined symbol");
-    return alphabet[(int)symb];
+bool Symbol::operator!=(Symbol const &s) const {
+    return symb != s.symb;
+}
+
+/**
+ * The mapping between characters and symbols. Immutable once built, so
+ * one alphabet can be shared by any number of word lists,
+ * dictionaries and grids, in any number of threads. Characters outside
+ * the alphabet map to the undefined symbol.
+ */
+
+class Alphabet {
+    char chars[128];     // by symbol value, UNDEF if unused
+    Symbol index[256];   // by character
+    int nletters;
+public:
+    explicit Alphabet(const std::string &letters);
+    // the letters a to z, used where no alphabet is given
+    static const Alphabet &latin();
+
+    Symbol symbol(char ch) const { return index[(unsigned char)ch]; }
+    char letter(Symbol s) const { return chars[s.symbvalue()]; }
+    bool isletter(char ch) const { return symbol(ch).symbvalue() > 2 && symbol(ch).symbvalue() != UNDEF; }
+    int numletters() const { return nletters; }
+    SymbolSet letters() const;
+
+    std::string word(const Symbol *st) const; // up to Symbol::outside
+    std::string word(const Symbol *st, int len) const;
+    std::string letters(SymbolSet ss) const;
+};
+
+// the k'th lowest set bit of ss
+inline SymbolSet selectbit(SymbolSet ss, int k) {
+#if defined(__BMI2__)
+    return _pdep_u64(uint64_t(1) << k, ss);
+#else
+    while (k--)
+        ss &= ss - 1;
+    return ss & -ss;
+#endif
 }
 
-SymbolSet pickbit(SymbolSet &ss);
+// removes a random bit from ss and returns it, 0 if ss is empty
+SymbolSet pickbit(SymbolSet &ss, Random &rng);
 
 //////////////////////////////////////////////////////////////////////
 
-void dumpset(SymbolSet ss);
-void dumpsymbollist(Symbol *s, int n);
-std::ostream &operator <<(std::ostream &os, Symbol *s);
+void dumpset(SymbolSet ss, const Alphabet &a);
+void dumpsymbollist(Symbol *s, int n, const Alphabet &a);
 
-int wordlen(Symbol *st);
+int wordlen(const Symbol *st);
 
 int numones(SymbolSet ss);
 
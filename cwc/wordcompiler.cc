@@ -0,0 +1,197 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+
+#include <iostream>
+#include <algorithm>
+#include <vector>
+#include <limits.h>
+
+#include "wordcompiler.hh"
+
+//////////////////////////////////////////////////////////////////////
+// class wordcompiler
+
+WordCompiler::WordCompiler(Grid &thegrid, Dict &thedict)
+    : g(thegrid), d(thedict), cancel(0), nodes(0), backtracks(0), depth(0),
+      deadline(Compiler::Clock::time_point::max()), progress(0), nextcheck(0),
+      late(false) {
+    verbose = false;
+}
+
+// the words that still fit wb; if the dictionary cannot count them,
+// the letters possible in its most constrained open cell
+int WordCompiler::slotsize(WordBlock &wb) {
+    int n = wb.nummatches(d);
+    if (n >= 0) return n;
+    int len = wb.length();
+    n = INT_MAX;
+    for (int p = 0; p < len; p++)
+        if (wb.getcell(p).isempty())
+            n = std::min(n, numones(wb.findpossible(d, p)));
+    return n;
+}
+
+// the open block with the fewest words, 0 if all are full. Single cells
+// are not words, see Grid::attachdomains; fillsingles() does them.
+WordBlock *WordCompiler::pickslot(bool &dead) {
+    WordBlock *best = 0;
+    int bestsize = INT_MAX;
+    dead = false;
+    int nblocks = g.numwordblocks();
+    for (int i = 0; i < nblocks; i++) {
+        WordBlock &wb = g.wordblock(i);
+        int len = wb.length();
+        if (len < 2) continue;
+        bool open = false;
+        for (int p = 0; p < len && !open; p++)
+            open = wb.getcell(p).isempty();
+        if (!open) continue;
+        int size = slotsize(wb);
+        if (size == 0) {
+            dead = true;
+            return 0;
+        }
+        if (size < bestsize) {
+            best = &wb;
+            bestsize = size;
+        }
+    }
+    return best;
+}
+
+// read the clock once in a while; past the deadline, the search
+// unwinds as if cancelled
+void WordCompiler::checkclock() {
+    if (nodes < nextcheck) return;
+    nextcheck = nodes + 64;
+    Compiler::Clock::time_point now = Compiler::Clock::now();
+    if (now >= deadline)
+        late = true;
+    else if (progress && now >= report) {
+        progress->progress(nodes, backtracks, depth);
+        report = now + std::chrono::milliseconds(progress->interval);
+    }
+}
+
+bool WordCompiler::fillrest() {
+    checkclock();
+    if (cancelled()) return false;
+    bool dead;
+    WordBlock *wb = pickslot(dead);
+    if (dead) {
+        backtracks++;
+        return false;
+    }
+    if (!wb) return fillsingles();
+    if (verbose)
+        std::cout << "filling a word of " << wb->length() << ", "
+                  << slotsize(*wb) << " fit" << std::endl;
+    return fillword(*wb, 0);
+}
+
+// spell out the rest of a word in wb from pos on, trying the letters
+// that both words of each cell allow, and go on with the grid once the
+// word is whole
+bool WordCompiler::fillword(WordBlock &wb, int pos) {
+    int len = wb.length();
+    while (pos < len && !wb.getcell(pos).isempty())
+        pos++;
+    if (pos == len) {
+        nodes++;
+        depth++;
+        bool ok = fillrest();
+        depth--;
+        return ok;
+    }
+    Cell &cell = wb.getcell(pos);
+    SymbolSet ss = cell.findpossible(d);
+    if (!ss)
+        backtracks++;
+    for (SymbolSet bit = pickbit(ss, rng); bit; bit = pickbit(ss, rng)) {
+        cell.setsymbol(Symbol::symbolbit(bit));
+        if (fillword(wb, pos + 1)) return true;
+        if (cancelled()) break;
+    }
+    cell.setsymbol(Symbol::empty);
+    return false;
+}
+
+// open cells in no word: any letter the dictionary allows
+bool WordCompiler::fillsingles() {
+    std::vector<int> filled;
+    int ncells = g.numcells();
+    for (int c = 0; c < ncells; c++) {
+        Cell &cell = g.cellno(c);
+        if (!cell.isempty() || cell.numwords() == 0) continue;
+        SymbolSet ss = cell.findpossible(d);
+        if (!ss) {
+            for (unsigned i = 0; i < filled.size(); i++)
+                g.cellno(filled[i]).setsymbol(Symbol::empty);
+            return false;
+        }
+        cell.setsymbol(Symbol::symbolbit(pickbit(ss, rng)));
+        filled.push_back(c);
+    }
+    return true;
+}
+
+bool WordCompiler::compile() {
+    nodes = 0;
+    backtracks = 0;
+    depth = 0;
+    nextcheck = 0;
+    late = false;
+    return fillrest();
+}
+
+// The search unwinds on its way out, so the grid is left as it was
+// whenever no fill is found.
+Compiler::Result WordCompiler::compile(Compiler::Clock::time_point until,
+                                       std::atomic<bool> *cancelflag, Progress *p) {
+    std::atomic<bool> *saved = cancel;
+    if (cancelflag)
+        cancel = cancelflag;
+    deadline = until;
+    progress = p;
+    report = Compiler::Clock::now();
+    if (progress)
+        report += std::chrono::milliseconds(progress->interval);
+
+    Compiler::Result r;
+    bool ok = compile();
+    r.nodes = nodes;
+    r.backtracks = backtracks;
+    if (ok)
+        r.outcome = Compiler::solved;
+    else if (late)
+        r.outcome = Compiler::timeout;
+    else if (cancelled())
+        r.outcome = Compiler::cancelled;
+    else
+        r.outcome = Compiler::unsat;
+
+    cancel = saved;
+    deadline = Compiler::Clock::time_point::max();
+    progress = 0;
+    late = false;
+    return r;
+}
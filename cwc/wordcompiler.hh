@@ -0,0 +1,84 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+
+#ifndef CWC_WORDCOMPILER_HH
+#define CWC_WORDCOMPILER_HH
+
+#include <atomic>
+#include <stdint.h>
+#include "grid.hh"
+#include "dict.hh"
+#include "random.hh"
+#include "cwc.hh"
+
+/**
+ * Fills a grid a word at a time instead of a cell at a time. It takes
+ * the open word block that the fewest words still fit, and gives it
+ * each of those words in turn before going on to the next block.
+ *
+ * The words are spelled out through the dictionary: each letter must
+ * be possible in the word block and in the block that crosses it, so
+ * every word tried fits its block and leaves a word to every crossing
+ * one. A dead end therefore shows up in the block being filled, not
+ * several levels deeper.
+ *
+ * Works on the same Grid and Dict as a Compiler, slot domains
+ * included, and leaves the fill in the grid in the same way.
+ */
+
+class WordCompiler {
+    Grid &g;
+    Dict &d;
+    Random rng;
+    std::atomic<bool> *cancel;
+    long nodes, backtracks;
+    int depth;
+    // for compile() with a deadline
+    Compiler::Clock::time_point deadline, report;
+    Progress *progress;
+    long nextcheck;
+    bool late;
+    bool cancelled() { return late || (cancel && cancel->load(std::memory_order_relaxed)); }
+    void checkclock();
+    int slotsize(WordBlock &wb);
+    WordBlock *pickslot(bool &dead);
+    bool fillrest();
+    bool fillword(WordBlock &wb, int pos);
+    bool fillsingles();
+public:
+    WordCompiler(Grid &thegrid, Dict &thedict);
+    bool compile();
+    // as Compiler::compile() with a deadline; depth counts words
+    Compiler::Result compile(Compiler::Clock::time_point deadline,
+                             std::atomic<bool> *cancelflag = 0, Progress *progress = 0);
+
+    bool verbose;
+    void setseed(uint64_t seed) { rng.setseed(seed); }
+    uint64_t getseed() { return rng.getseed(); }
+    void setcancel(std::atomic<bool> *flag) { cancel = flag; }
+    // words tried, and dead ends met: slots with no word left and
+    // cells with no letter
+    long getnodes() { return nodes; }
+    long getbacktracks() { return backtracks; }
+};
+
+#endif // CWC_WORDCOMPILER_HH
@@ -22,7 +22,7 @@
 #include <fstream>
 #include "wordlist.hh"
 
-WordList::WordList() {
+WordList::WordList(const Alphabet &a) : alpha(a) {
     allalpha = 0;
 }
 
@@ -30,7 +30,7 @@ WordList::WordList() {
 bool WordList::wordok(const std::string &fn) {
     int n = fn.length();
     for (int i=0;i<n;i++)
-        if (!isalpha(fn[i]))
+        if (!alpha.isletter(tolower(fn[i])))
             return false;
     return true;
 }
@@ -71,7 +71,7 @@ void WordList::addWord(const std::string &word)
 
     Symbol *addr = chunk + chunkused;
     for (int i=0; i<wordLength; i++) {
-        Symbol s = Symbol(tolower(word[i]));
+        Symbol s = alpha.symbol(tolower(word[i]));
         chunk[chunkused++] = s;
         allalpha |= s.getsymbolset();
     }
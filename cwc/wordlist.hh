@@ -28,7 +28,8 @@
 /**
  * the wordlist is a container class for the words loaded from
  * a file. Words are referenced by a integer index. The words
- * are sorted.
+ * are sorted. Words with characters outside the alphabet are
+ * skipped.
  */
 
 class WordList
@@ -37,7 +38,8 @@ class WordList
 
 public:
     SymbolSet allalpha;
-    WordList();
+    WordList(const Alphabet &a = Alphabet::latin());
+    const Alphabet &alphabet() { return alpha; }
     void load(const std::string &fn);
     void addWord(const std::string &word);
     int numwords() {
@@ -49,6 +51,7 @@ public:
     }
 
 protected:
+    const Alphabet &alpha;
     std::vector<Symbol*> widx;
     bool wordok(const std::string &st);
     int nwords;
@@ -8,9 +8,6 @@
 #include "crossword.h"
 #include "drawablecell.h"
 
-#include <time.h>
-#include "cwc/symbol.hh"
-
 #ifdef REMARKABLE_DEVICE
 #include <epframebuffer.h>
 
@@ -68,8 +65,6 @@ protected:
 int main(int argc, char *argv[])
 {
     setlocale(LC_CTYPE, "");
-    Symbol::buildindex();
-    qsrand(time(0));
 
 #ifdef REMARKABLE_DEVICE
     qputenv("QMLSCENE_DEVICE", "epaper");
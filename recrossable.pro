@@ -1,5 +1,5 @@
 QT += quick
-CONFIG += c++11
+CONFIG += c++11 thread
 
 #CONFIG += sanitizer sanitize_address
 
@@ -17,12 +17,25 @@ DEFINES += QT_DEPRECATED_WARNINGS
 SOURCES += \
     main.cpp \
     crossword.cpp \
+    cwc/bitdict.cc \
+    cwc/cacheddict.cc \
     cwc/cwc.cc \
     cwc/dict.cc \
+    cwc/domain.cc \
     cwc/grid.cc \
     cwc/letterdict.cc \
+    cwc/mappeddict.cc \
+    cwc/nogood.cc \
+    cwc/parallel.cc \
+    cwc/portfolio.cc \
+    cwc/postings.cc \
+    cwc/random.cc \
+    cwc/restart.cc \
+    cwc/scandict.cc \
+    cwc/selectdict.cc \
     cwc/symbol.cc \
     cwc/timer.cc \
+    cwc/wordcompiler.cc \
     cwc/wordlist.cc \
     drawablecell.cpp \
     characterrecognizer.cpp
@@ -46,13 +59,26 @@ else: unix:!android: target.path = /opt/$${TARGET}/bin
 
 HEADERS += \
     crossword.h \
+    cwc/bitdict.hh \
+    cwc/cacheddict.hh \
     cwc/cwc.hh \
     cwc/dict.hh \
+    cwc/domain.hh \
     cwc/grid.hh \
     cwc/letterdict.hh \
     cwc/main.hh \
+    cwc/mappeddict.hh \
+    cwc/nogood.hh \
+    cwc/parallel.hh \
+    cwc/portfolio.hh \
+    cwc/postings.hh \
+    cwc/random.hh \
+    cwc/restart.hh \
+    cwc/scandict.hh \
+    cwc/selectdict.hh \
     cwc/symbol.hh \
     cwc/timer.hh \
+    cwc/wordcompiler.hh \
     cwc/wordlist.hh \
     drawablecell.h \
     characterrecognizer.h